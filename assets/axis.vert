@@ -3,8 +3,11 @@ layout (location = 0) in vec3 aPos;
 
 out vec3 vertexPosition;
 
-uniform mat4 projection = mat4(1.0);
-uniform mat4 view = mat4(1.0);
+
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+};
 
 void main()
 {
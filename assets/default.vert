@@ -4,9 +4,12 @@ layout (location = 1) in vec2 aUV;
 
 out vec2 texCoords;
 
-uniform mat4 projection = mat4(1.0);
 uniform mat4 transform = mat4(1.0);
-uniform mat4 view = mat4(1.0);
+
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+};
 
 void main()
 {
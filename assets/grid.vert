@@ -7,8 +7,11 @@ out vec2 texCoords;
 
 uniform vec2 gridOffset[4];
 uniform float objectScale = 10.0;
-uniform mat4 projection = mat4(1.0);
-uniform mat4 view = mat4(1.0);
+
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+};
 
 void main()
 {
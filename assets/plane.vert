@@ -1,19 +1,29 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 // layout (location = 1) in vec2 aUV;
+// Per-instance, see InstanceAttributePlane
+layout (location = 1) in mat4 aPlaneTransform;
+layout (location = 5) in vec3 aPositiveColor;
+layout (location = 6) in float aIsVisible;
 
 out vec2 texCoords;
+flat out vec3 positiveColor;
 
 // FIXME: Make shaders more shared/reusable. Sure, they're small, but still.
 uniform mat4 globalScale = mat4(1.0);
-uniform mat4 planeTransform = mat4(1.0);
-uniform mat4 projection = mat4(1.0);
 uniform mat4 transform = mat4(1.0);
-uniform mat4 view = mat4(1.0);
+
+// Shared with every other shader, filled once per frame (CameraBlock)
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+};
 
 void main()
 {
     texCoords = vec2(aPos.x, aPos.y);
-    vec4 transformedPlane = globalScale * planeTransform * globalScale * vec4(aPos, 1.0);
-    gl_Position = projection * view * transform * transformedPlane;
+    positiveColor = aPositiveColor;
+    vec4 transformedPlane = globalScale * aPlaneTransform * globalScale * vec4(aPos, 1.0);
+    // Hidden planes collapse into a point and get dropped before rasterization
+    gl_Position = aIsVisible * (projection * view * transform * transformedPlane);
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <glm/glm.hpp>
 
 struct VertexAttributePosition {
@@ -10,6 +12,12 @@ struct VertexAttributePositionUV {
     float position[3];
     float uv[2];
 };
+// Per-instance, goes in at locations 1-4 (transform columns), 5 and 6
+struct InstanceAttributePlane {
+    glm::mat4 transform;
+    glm::vec3 positiveColor;
+    float isVisible;
+};
 
 class Object {
     private:
@@ -17,6 +25,8 @@ class Object {
     unsigned int indices;
     unsigned int objectData;
     unsigned int vertexCount;
+    unsigned int instanceData;
+    size_t instanceCapacity;
     const char* meshName;
 
     void genArrays();
@@ -29,6 +39,18 @@ class Object {
     void setVertexData(VertexAttributePositionUV* vertexData, size_t vertexCount, int* indices, size_t indexCount);
     void setFaceData(); // Unimplemented
 
+    /**
+     * (Re)allocates the instance buffer for capacity instances, uploads the first count of them
+     * and hooks it up to the VAO with a divisor of 1.
+     */
+    void setInstanceData(const InstanceAttributePlane* instances, size_t count, size_t capacity);
+    /**
+     * Overwrites count instances starting at offset, buffer stays as is.
+     * @throws std::runtime_error when it doesn't fit into what setInstanceData() allocated
+     */
+    void updateInstanceData(const InstanceAttributePlane* instances, size_t offset, size_t count);
+    size_t getInstanceCapacity() const;
+
     static std::shared_ptr<Object> fromWavefront(const char* objectLocation);
 
     void bindForDraw(unsigned int mode) const;
@@ -43,21 +65,92 @@ class Object {
     ~Object();
 };
 
+// Binding points for uniform blocks. GLSL 330 can't spell them out, so Shader hooks the blocks up by name
+enum UniformBlockBinding {
+    UNIFORM_BLOCK_CAMERA = 0 // "Camera"
+};
+
+// std140 lays mat4s out the same way glm does, so no padding games here
+struct CameraBlock {
+    glm::mat4 projection;
+    glm::mat4 view;
+};
+
+class UniformBuffer {
+    private:
+    unsigned int bufferData;
+    size_t bufferSize;
+
+    public:
+    UniformBuffer(size_t size, UniformBlockBinding binding);
+
+    /**
+     * Overwrites size bytes at offset.
+     * @throws std::runtime_error when that runs past the end of the buffer
+     */
+    void update(const void* data, size_t size, size_t offset = 0);
+    template <typename T>
+    void update(const T& block) { this->update(&block, sizeof(T)); }
+
+    ~UniformBuffer();
+};
+
+/**
+ * Uniform location, resolved once through Shader::getUniform().
+ * The type is only there so a vec3 handle can't be fed a mat4 by accident.
+ * Location -1 is what GL uses for "no such uniform", setting it does nothing.
+ */
+template <typename T>
+struct UniformHandle {
+    int location = -1;
+    const char* name = nullptr; // For Shader::isLookingUpEveryCall. Has to outlive the handle, literals do
+};
+
 class Shader {
     private:
     unsigned int pShaderProgram;
+    // Filled in once after linking, name -> location
+    std::unordered_map<std::string, int> uniformLocations;
     Shader(unsigned int programId);
 
     static std::unique_ptr<char>sCompileLog;
     static unsigned int compileShader(const char* shaderSource, unsigned int shaderType);
     static unsigned int linkProgram(unsigned int vertexStage, unsigned int fragmentStage) noexcept(false);
+    void reflectUniforms();
+    void bindUniformBlock(const char* blockName, UniformBlockBinding binding);
+    int locate(const char* name) const;
+
+    static void upload(int location, int value);
+    static void upload(int location, float value);
+    static void upload(int location, double value);
+    static void upload(int location, glm::vec2 value);
+    static void upload(int location, glm::vec3 value);
+    static void upload(int location, glm::vec4 value);
+    static void upload(int location, const glm::mat2& value);
+    static void upload(int location, const glm::mat3& value);
+    static void upload(int location, const glm::mat4& value);
     public:
+    /**
+     * Asks GL for the location by name on every set, handles included, same as before there was a cache.
+     * Off unless someone's timing the two against each other (LPPRender --uniform-lookups).
+     */
+    static bool isLookingUpEveryCall;
+
     Shader(char const* vertexShaderPath, char const* fragmentShaderPath);
 
     static Shader* fromSource(const char* vertexSource, const char* fragmentSource);
 
     void activate() const;
-    void setTransform(glm::mat4 projectionMatrix, glm::mat4 viewMatrix) const;
+
+    // Costs a hash lookup, use handles where it's called a lot
+    template <typename T>
+    UniformHandle<T> getUniform(const char* name) const { return UniformHandle<T> { this->locate(name), name }; }
+
+    template <typename T>
+    void setUniform(UniformHandle<T> handle, const T& value) const {
+        bool isLookingUp = Shader::isLookingUpEveryCall && handle.name != nullptr;
+        Shader::upload(isLookingUp ? this->locate(handle.name) : handle.location, value);
+    }
 
     void setUniform(const char* name, int value) const;
     void setUniform(const char* name, float value) const;
@@ -2,9 +2,20 @@
 #include <glm/glm.hpp>
 #include <string>
 
+// Preset views: the numpad snaps plus the one we start in
+enum CameraView {
+    VIEW_DEFAULT = 0,
+    VIEW_TOP = 1,   // Numpad 7
+    VIEW_LEFT = 2,  // Numpad 1
+    VIEW_RIGHT = 3  // Numpad 3
+};
+
 class Camera {
     private:
     glm::mat4 projectionMatrix;
+    glm::mat4 viewMatrix;
+    bool isViewDirty = true; // lookAt only when something actually moved
+    unsigned long revision = 0; // Goes up on every move, turn or lens change
     glm::vec3 mDirection;
     glm::vec3 mLocation;
     glm::vec3 mRotation;
@@ -21,6 +32,7 @@ class Camera {
     void applyRotation();
     void recalcProjection();
     void updateOrbitDepth();
+    void invalidateView();
 
     public:
     float lookInSensitivity = 15.0f;
@@ -51,6 +63,9 @@ class Camera {
     void walk(float forwards, float backwards, float ascend);
     void walk(float forwards, float backwards, float ascend, glm::vec3 axisMask);
 
+    // Ortho for the axis-aligned ones, perspective for the default. Keeps lookDepth, except for the default
+    void snapTo(CameraView view);
+
     void orbit(double deltaX, double deltaY);
     void zoom(double deltaX, double deltaY);
     void pan(double deltaX, double deltaY);
@@ -61,6 +76,7 @@ class Camera {
 
     glm::mat4 getView();
     glm::mat4 getProjection();
+    unsigned long getRevision() const;
 
     float getFOV() const;
 };
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "assets.h"
+#include "solver.h"
+
+// GL side of the solver. Everything in here wants a live context, solver.h doesn't.
+class FrameProfiler;
+
+class Display:public LinearProgrammingProblem {
+    private:
+    std::shared_ptr<Object> planeObject;
+    std::shared_ptr<Shader> planeShader;
+
+    std::shared_ptr<Object> vectorDisplay;
+
+    std::shared_ptr<Shader> solutionShader;
+    std::shared_ptr<Object> solutionObject;
+    std::shared_ptr<Object> solutionWireframe;
+    // Uploaded meshes of the last few regions, most recent first. Whenever a solve comes back
+    // with a region we've drawn before (a solution cache hit, usually) they just get swapped back in
+    struct SolutionMeshes {
+        uint64_t regionId;
+        std::shared_ptr<Object> volume;
+        std::shared_ptr<Object> wireframe;
+    };
+    std::vector<SolutionMeshes> solutionMeshes;
+    // Resolved in createShaders(), these get set every frame
+    UniformHandle<glm::mat4> planeGlobalScaleUniform;
+    UniformHandle<float> planeStripeScaleUniform;
+    UniformHandle<float> planeStripeWidthUniform;
+    UniformHandle<glm::mat4> solutionTransformUniform;
+    UniformHandle<glm::vec3> solutionColorUniform;
+    // One per plane, mirrored into planeObject's instance buffer
+    std::vector<InstanceAttributePlane> planeInstances;
+    // [dirtyFrom, dirtyTo) is what changed since the last upload
+    size_t dirtyFrom = SIZE_MAX;
+    size_t dirtyTo = 0;
+
+    glm::mat4 optimalPlanTransform;
+    glm::mat4 globalScaleTransform = glm::mat4(1);
+
+    void createObjects();
+    void createShaders();
+
+    void recalculatePlane(int planeIndex);
+    void recalculateOptimalPlan();
+    void markDirty(size_t from, size_t to);
+    void rebindAttributes();
+    void onSolutionSolved();
+    void onOptimumUpdated();
+    void onPlaneAdded(int planeIndex);
+    void onPlaneUpdated(int planeIndex);
+    void onPlaneRemoved(int planeIndex);
+    void onPlanesCompacted(const std::vector<int>& survivors);
+    void onReset();
+
+    public:
+    FrameProfiler* profiler = nullptr; // Not ours, just timing into it if there's one
+    bool showPlanesAtAll = true;
+    bool showSolutionVolume = true;
+    bool showSolutionVector = true;
+    bool showSolutionWireframe = true;
+    double globalScale = 1.0;
+    float stripeFrequency = 15.0;
+    float stripeWidth = 0.20;
+    float wireThickness = 5.0;
+    float vectorWidth = 0.04;
+    float arrowScale = 2.5;
+
+    std::vector<glm::vec3> constraintPositiveColors = {
+        {0.9608, 0.7294, 0.4510}, // {0.9216, 0.2863, 0.4627},
+        {0.5843, 0.3529, 0.9608}, // {0.1922, 0.3647, 0.9216},
+        {0.2118, 0.6588, 0.3059}  // {0.9216, 0.6980, 0.1020},
+                                  // {0.1490, 0.9216, 0.2431}
+    };
+    glm::vec3 solutionColor = {1.0, 0.746282, 0.043526};
+    glm::vec3 solutionVectorColor = { 0, 0, 0 }; // {0.128, 0.833, 0.272};
+    glm::vec3 solutionWireframeColor = {0.8, 0.095672, 0.019807};
+
+    Display();
+
+    void setScale(double scale);
+    bool isPlaneVisible(int planeIndex) const;
+    void setPlaneVisible(int planeIndex, bool isVisible);
+    // Call after touching constraintPositiveColors, every plane has to pick its colour again
+    void invalidatePlaneColors();
+    void render();
+
+    ~Display();
+};
+
+class WorldGridDisplay {
+    private:
+    std::shared_ptr<Object> gridObject;
+    std::shared_ptr<Object> axisObject;
+    std::shared_ptr<Shader> gridShader;
+    std::shared_ptr<Shader> axisShader;
+    // Resolved in createShaders(), set twice a frame
+    UniformHandle<float> gridScaleUniform;
+    UniformHandle<float> gridStrokeWidthUniform;
+    int scaleExponent = 0;
+
+    void createObjects();
+    void createShaders();
+
+    public:
+    FrameProfiler* profiler = nullptr;
+    bool gridEnabled = true;
+    bool axisEnabled = true;
+
+    float gridScale = 1.0;
+    float gridWidth = 0.05;
+
+    WorldGridDisplay();
+
+    void zoomGrid(float zoomAmount);
+    double getComputedScale();
+    void render();
+
+    ~WorldGridDisplay();
+};
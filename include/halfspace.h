@@ -0,0 +1,23 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "solver.h"
+
+/**
+ * Turns raw plane -> vertex incidence (facets.planes[i] owning vertices[offsets[i]..offsets[i + 1]])
+ * into actual faces: planes through fewer than three vertices are edges or corners, not faces,
+ * coinciding planes would give the same face twice, and what's left gets sorted counter-clockwise
+ * around the outward normal, normals[facets.planes[i]].
+ */
+void buildFacets(const std::vector<float>& vertices, const std::vector<glm::dvec3>& normals, FacetIncidence& facets);
+
+/**
+ * Vertex enumeration for a bounded region, through a convex hull in the dual space.
+ * Takes halfspaces in form of A1 A2 A3 <= B (xyz is A, w is B), same as seidelMaximize().
+ * Fills vertices (flat xyz), adjacency and facets in the same shape cddlib's path does,
+ * except facets.planes index into halfspaces.
+ * Returns false if the region is empty, unbounded or flat, which is the double description's job.
+ * No half-written output is left behind then, there may be no cddlib to fill it in afterwards.
+ */
+bool intersectHalfspaces(const std::vector<glm::dvec4>& halfspaces, std::vector<float>& vertices, Adjacency& adjacency, FacetIncidence& facets);
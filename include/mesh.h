@@ -0,0 +1,16 @@
+#pragma once
+#include <vector>
+
+#include "solver.h"
+
+// Index buffers for the region, GL-free so the batch tools and benchmarks can build them too
+
+/**
+ * Triangles over the region's vertices: each face fanned out from its first vertex,
+ * counter-clockwise from outside. Open regions (isBounded off) or ones with no faces
+ * go through quickhull over the vertices instead, which needs a cddlib build.
+ */
+std::vector<unsigned int> getSolutionTriangles(const std::vector<float>& vertices, const FacetIncidence& facets, bool isBounded);
+
+// Line pairs, every edge once (the low-to-high end)
+std::vector<unsigned int> getSolutionEdges(const std::vector<float>& vertices, const Adjacency& adjacency);
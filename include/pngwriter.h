@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/**
+ * Just enough PNG to get renders out: 8-bit RGBA, rows top to bottom.
+ * Compression is a single fixed-Huffman deflate block with greedy matching, which is
+ * nowhere near zlib but does fine on flat-shaded figures and needs no dependencies.
+ */
+std::vector<unsigned char> encodePNG(int width, int height, const unsigned char* rgba);
+
+/**
+ * encodePNG() straight into a file.
+ * @throws std::runtime_error if the file can't be written
+ */
+void writePNG(const std::string& path, int width, int height, const unsigned char* rgba);
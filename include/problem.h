@@ -0,0 +1,31 @@
+#pragma once
+#include <istream>
+#include <ostream>
+
+#include <glm/glm.hpp>
+#include "solver.h"
+
+/**
+ * Plain text problems, one statement per line:
+ *
+ *   # comments go after a hash
+ *   maximize 2 3 0 1     <- objective, "max"/"min" work too. Fourth number is the constant, optional
+ *   1 0 0 <= 1           <- A1 A2 A3 (<=|>=|=) B
+ *   0 1 0 >= 0
+ *   ---                  <- ends this problem, the next one starts below
+ *
+ * No objective line means minimizing zero, which is a fine way to just look at the region.
+ */
+
+/**
+ * Reads the next problem off the stream into problem, after a reset().
+ * Stops at a "---" line or the end of the stream.
+ * lineNumber is where the stream is at, kept across calls so errors point at the right line.
+ * Returns false if there was nothing left to read.
+ * @throws std::runtime_error on anything it can't parse, with the line number in the message
+ */
+bool readProblem(std::istream& input, LinearProgrammingProblem& problem, int& lineNumber);
+bool readProblem(std::istream& input, LinearProgrammingProblem& problem);
+
+// Same format back out, so whatever this writes readProblem() can read
+void writeProblem(std::ostream& output, LinearProgrammingProblem& problem);
@@ -0,0 +1,87 @@
+#pragma once
+#include <chrono>
+
+// What we time, in the order it happens during a frame
+enum ProfileSection {
+    PROFILE_IMGUI_BUILD = 0,
+    PROFILE_GRID,
+    PROFILE_PLANES,
+    PROFILE_SOLUTION,
+    PROFILE_IMGUI_RENDER,
+    PROFILE_SECTION_COUNT
+};
+
+/**
+ * CPU and GPU time per section, over the last HISTORY_SIZE frames.
+ * GPU side runs on GL_TIME_ELAPSED queries, QUERY_SET_COUNT sets of them taking turns so that
+ * drivers queueing a few frames ahead still get to finish them. Results are picked up whenever
+ * they're ready, without waiting, and go back to the frame that issued them. A set that still isn't
+ * done by the time it comes around again gets dropped, and that frame goes without a GPU sample.
+ * Samples that never came in are NaN, and left out of both averages and graphs.
+ * Frame time runs from newFrame() to endFrame(), so time spent asleep between frames doesn't count.
+ * TIME_ELAPSED queries can't nest, so neither can sections.
+ * Everything's a no-op while isEnabled is off, queries included.
+ */
+class FrameProfiler {
+    public:
+    static const int HISTORY_SIZE = 120;
+    static const int QUERY_SET_COUNT = 4;
+
+    private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Section {
+        unsigned int queries[QUERY_SET_COUNT] = {};
+        bool isQueryIssued[QUERY_SET_COUNT] = {};
+        int issuedSlot[QUERY_SET_COUNT] = {}; // Which frame's history each query belongs to
+        Clock::time_point startedAt;
+        float cpuMilliseconds[HISTORY_SIZE];
+        float gpuMilliseconds[HISTORY_SIZE];
+    };
+
+    Section sections[PROFILE_SECTION_COUNT];
+    float frameMilliseconds[HISTORY_SIZE];
+    Clock::time_point frameStartedAt;
+    int historyOffset = 0; // Slot being written, the one after it is the oldest
+    int querySet = 0;
+    int activeSection = -1;
+    bool hasQueries = false;
+
+    void collectQueries();
+
+    public:
+    bool isEnabled = false;
+
+    FrameProfiler();
+
+    // Call once per frame, as soon as it starts and before any section. Moves the history along
+    void newFrame();
+    // Call once the frame's out, right after the swap
+    void endFrame();
+    void begin(ProfileSection section);
+    void end(ProfileSection section);
+
+    // Over the samples there are, 0 if there's none
+    float getAverageCPU(ProfileSection section) const;
+    float getAverageGPU(ProfileSection section) const;
+    float getAverageFrame() const;
+    static const char* getSectionName(ProfileSection section);
+
+    // ImGui window with a graph per section
+    void draw(bool* isOpen);
+    // Needs the GL context, so it has to happen before that's gone
+    void release();
+
+    ~FrameProfiler();
+};
+
+// begin() now, end() when it goes out of scope. Takes a nullptr to mean "not profiling".
+class ProfileScope {
+    private:
+    FrameProfiler* profiler;
+    ProfileSection section;
+
+    public:
+    ProfileScope(FrameProfiler* profiler, ProfileSection section);
+    ~ProfileScope();
+};
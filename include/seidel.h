@@ -0,0 +1,32 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+
+enum SeidelStatus {
+    SEIDEL_OPTIMAL = 0,
+    SEIDEL_INFEASIBLE = 1,
+    SEIDEL_UNBOUNDED = 2,
+    SEIDEL_DEGENERATE = 3 // Couldn't trust the answer, ask someone exact (cddlib)
+};
+
+struct SeidelResult {
+    SeidelStatus status = SEIDEL_DEGENERATE;
+    glm::dvec3 point = glm::dvec3(0);
+    double value = 0; // Only filled in by seidelChebyshevCenter(), as the radius
+};
+
+/**
+ * Seidel's randomized incremental LP, for up to 3 variables. Expected O(n) in the amount of rows.
+ * Maximizes objective·x over halfspaces in form of A1 A2 A3 <= B (xyz is A, w is B).
+ * Equalities have to come in as two opposing halfspaces.
+ * Axes no halfspace talks about are left at 0. Ties are broken towards the smallest x, then y, then z.
+ * Plain doubles, so near-parallel planes and the like come back as SEIDEL_DEGENERATE.
+ */
+SeidelResult seidelMaximize(const std::vector<glm::dvec4>& halfspaces, glm::dvec3 objective);
+
+/**
+ * Center of the largest ball that fits inside the halfspaces, same form as above.
+ * The radius goes into value; zero or less means there's no interior (equalities, flat regions).
+ * SEIDEL_UNBOUNDED if the region runs off far enough for the center to go with it.
+ */
+SeidelResult seidelChebyshevCenter(const std::vector<glm::dvec4>& halfspaces);
@@ -1,10 +1,181 @@
 #pragma once
 
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
 enum EquationType {
     LESS_EQUAL_THAN = 0,
     GREATER_EQUAL_THAN = 1,
     EQUAL_TO = 2
 };
+
+// Who gets to find the optimum. Vertices are EnumerationEngine's business
+enum SolverEngine {
+    ENGINE_CDDLIB = 0,
+    ENGINE_SEIDEL = 1 // Falls back to cddlib whenever it's unsure
+};
+
+// Who gets to find the vertices. The dual hull is the default
+enum EnumerationEngine {
+    ENUMERATION_DOUBLE_DESCRIPTION = 0, // cddlib, handles anything
+    ENUMERATION_DUAL_HULL = 1, // Quickhull in the dual, bounded regions with some volume only. Falls back to the above otherwise, if there's cddlib
+    ENUMERATION_NONE = 2 // Optimum only, no vertices or adjacency. For when nobody's going to look at the region
+};
+/**
+ * Owns cddlib's global constants (dd_zero, dd_one and friends).
+ * cddlib keeps a single set of them per process, so there's a single context as well.
+ * It's brought up on the first solve and torn down when the program exits,
+ * instead of doing the whole dance on every solve() call.
+ * cddlib isn't reentrant either (the LP code keeps scratch in statics), hence the lock.
+ */
+class SolverContext {
+    private:
+    SolverContext();
+
+    public:
+    SolverContext(const SolverContext&) = delete;
+    SolverContext& operator=(const SolverContext&) = delete;
+
+    static SolverContext& get();
+
+    // Hold it for anything that calls into cddlib
+    std::mutex lock;
+
+    ~SolverContext();
+};
+
+/**
+ * Stable name for a plane. Dense indices shuffle around as planes get removed, handles don't.
+ * The generation makes sure a handle to a removed plane doesn't wake up pointing at whatever took its slot.
+ */
+struct PlaneHandle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const PlaneHandle& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const PlaneHandle& other) const { return !(*this == other); }
+};
+
+/**
+ * One problem for LinearProgrammingProblem::solveBatch(). Only points at the caller's planes,
+ * so those have to stay put until the batch is done.
+ */
+struct BatchProblem {
+    const glm::vec4* planes = nullptr; // A1 A2 A3 B, same as addLimitPlane()
+    const EquationType* types = nullptr; // One per plane, or nullptr for all of them being <=
+    uint32_t planeCount = 0;
+    glm::vec4 objectiveFunction = glm::vec4(0);
+    bool doMinimize = true;
+};
+
+enum BatchStatus : uint8_t {
+    BATCH_OPTIMAL = 0,
+    BATCH_INFEASIBLE = 1,
+    BATCH_UNBOUNDED = 2,
+    BATCH_ERROR = 3 // cddlib threw, or said something that isn't any of the above
+};
+
+// Optimum only, 20 bytes flat. Vector and value are only meaningful for BATCH_OPTIMAL
+struct BatchResult {
+    glm::vec3 optimalVector;
+    float optimalValue;
+    BatchStatus status;
+};
+
+/**
+ * Vertex adjacency in compressed sparse row form: vertex i's neighbours are
+ * neighbours[offsets[i]] up to (not including) neighbours[offsets[i + 1]], sorted and counted from 0.
+ * Two allocations total, however many vertices there are. Every edge shows up from both ends.
+ */
+struct Adjacency {
+    std::vector<uint32_t> offsets; // One per vertex plus the end, or nothing at all
+    std::vector<uint32_t> neighbours;
+
+    size_t getVertexCount() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    size_t getEdgeCount() const { return neighbours.size() / 2; }
+    void clear() { offsets.clear(); neighbours.clear(); }
+};
+
+/**
+ * Faces of the region, same CSR shape as Adjacency: face i goes through vertices[offsets[i]]
+ * up to vertices[offsets[i + 1]], counter-clockwise as seen from outside, so it fans into triangles as is.
+ * planes[i] is the plane it lies on (the first one, if several planes coincide).
+ * Open regions only get the faces that have three vertices or more, the rest go off along rays.
+ */
+struct FacetIncidence {
+    std::vector<uint32_t> offsets; // One per face plus the end, or nothing at all
+    std::vector<uint32_t> vertices;
+    std::vector<uint32_t> planes;
+
+    size_t getFacetCount() const { return planes.size(); }
+    void clear() { offsets.clear(); vertices.clear(); planes.clear(); }
+};
+
+// What SolveStats times, in the order a solve runs through them
+enum SolveStage {
+    STAGE_PRESOLVE = 0,       // Dropping scaled copies and looser parallels, redundant rows too if asked to
+    STAGE_SEIDEL,             // Seidel's LP, for the optimum
+    STAGE_DUAL_HULL,          // Vertices through the dual hull
+    STAGE_CDDLIB_WAIT,        // Queueing up for SolverContext's lock
+    STAGE_MATRIX,             // Filling in cddlib's constraint matrix
+    STAGE_MATRIX_TO_LP,       // dd_Matrix2LP
+    STAGE_LP_SOLVE,           // dd_LPSolve
+    STAGE_DOUBLE_DESCRIPTION, // dd_DDMatrix2Poly, or dd_DDAddInequalities when extending the cached one
+    STAGE_COPY_GENERATORS,    // dd_CopyGenerators
+    STAGE_COPY_ADJACENCY,     // dd_CopyAdjacency
+    STAGE_COPY_INCIDENCE,     // dd_CopyInputIncidence
+    STAGE_CONVERT,            // cddlib's generators into vertices and rays
+    STAGE_ADJACENCY,          // cddlib's adjacency sets into Adjacency
+    STAGE_FACETS,             // cddlib's incidence sets into FacetIncidence
+    STAGE_OBJECTIVE_ONLY,     // Picking a vertex off the last region, no solve at all
+    SOLVE_STAGE_COUNT
+};
+
+/**
+ * Where the last solve spent its time and how big things came out.
+ * Counts are always filled in. Timings need USE_SOLVE_STATS, without it the timers
+ * aren't compiled in at all and hasTimings stays false. Stages that didn't run stay at zero.
+ */
+struct SolveStats {
+    double stageMicroseconds[SOLVE_STAGE_COUNT] = {};
+    bool hasTimings = false;
+    bool isPolyhedraCached = false; // Double description reused (or extended) the last one
+    bool isSolutionCached = false; // Came straight out of the solution cache, nothing got solved (or timed)
+    uint32_t rowCount = 0; // What the solver got to see, after presolve
+    uint32_t redundantRowCount = 0; // What presolve threw out
+    uint32_t vertexCount = 0;
+    uint32_t rayCount = 0;
+    uint32_t edgeCount = 0;
+    uint32_t facetCount = 0;
+
+    double getTotalMicroseconds() const;
+    // snake_case, good for both the UI and lppsolve's output
+    static const char* getStageName(SolveStage stage);
+};
+
+// What a plane does to the region, see LinearProgrammingProblem::classifyConstraints()
+enum ConstraintClass : uint8_t {
+    CONSTRAINT_BINDING = 0,           // Holds up part of the region, it'd grow without this one
+    CONSTRAINT_REDUNDANT = 1,         // Take just this one out and the region stays the same
+    CONSTRAINT_IMPLICIT_EQUALITY = 2, // An inequality the whole region sits flat against, might as well be =
+    CONSTRAINT_UNKNOWN = 3            // Too close to call in doubles and no cddlib to ask, or the system's infeasible
+};
+
+// What the solution cache has been up to, see LinearProgrammingProblem::setSolutionCacheCapacity()
+struct SolutionCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    size_t entryCount = 0;
+    size_t bytes = 0; // Estimated, close enough to budget by
+    size_t capacityBytes = 0;
+};
+
 class LinearProgrammingProblem {
     private:
     struct Equation {
@@ -21,133 +192,186 @@ class LinearProgrammingProblem {
         std::string errorString;
         std::string statusString;
         std::vector<float> polyhedraVertices;
-        std::vector<std::vector<int>> adjacency;
+        std::vector<float> polyhedraRays; // Directions the region is open along, lines come in as both ways
+        Adjacency adjacency;
+        FacetIncidence facets;
+        std::vector<uint32_t> redundantPlanes; // Thrown out by presolve(), in order. Whatever's kept lands in facets.planes as usual
+        SolveStats stats;
+        // Same id, same vertices, adjacency and facets. Cache hits come back with the id they were first solved under
+        uint64_t regionId = 0;
+    };
+    // Last computed polyhedron, so appended planes don't need the whole thing redone. Lives in solver.cpp
+    struct PolyhedraCache;
+    // Solutions we've already paid for, least recently used goes first. Lives in solver.cpp too
+    struct SolutionCache;
+    /**
+     * The system boiled down so that the same problem typed in differently still comes out the same:
+     * >= flipped into <=, every row scaled down to its largest coefficient, then sorted.
+     * The objective goes in as is, its scale shows up in the optimal value.
+     */
+    struct SolutionKey {
+        std::vector<Equation> rows;
+        std::vector<uint32_t> planes; // rows[i] came from plane planes[i]
+        glm::vec4 objectiveFunction;
+        bool doMinimize;
+        SolverEngine engine;
+        EnumerationEngine enumeration;
+        bool dropRedundant; // Same region either way, but redundantPlanes isn't
+        uint64_t hash = 0;
+    };
+    // Everything solve() needs, copied out so it can be handed over to a worker thread
+    struct Snapshot {
+        std::vector<Equation> planeEquations;
+        glm::vec4 objectiveFunction;
+        bool doMinimize;
+        SolverEngine engine;
+        EnumerationEngine enumeration;
+        std::shared_ptr<PolyhedraCache> polyhedra;
+        bool dropRedundant = false;
     };
+    // What the current solution was solved against, to tell objective-only edits apart
+    struct SolvedState {
+        unsigned long constraintsRevision = ~0ul;
+        glm::vec4 objectiveFunction;
+        bool doMinimize;
+        SolverEngine engine;
+        EnumerationEngine enumeration; // Objective-only shortcut needs the vertices to be there
+        bool dropRedundant; // Changes what's in redundantPlanes, if not the region
+    };
+
+    struct PlaneSlot {
+        uint32_t denseIndex = 0;
+        uint32_t generation = 0;
+    };
+    // Slot map over planeEquations: handles point at slots, slots point at the dense array
+    std::vector<PlaneSlot> planeSlots;
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> planeSlotIndices; // Dense index -> slot, kept in step with planeEquations
+
+    std::future<Solution> pendingSolution;
+    bool discardPendingSolution = false;
+    // Dropped on any edit or removal. The worker might still hold on to the old one, that's fine.
+    std::shared_ptr<PolyhedraCache> polyhedraCache;
+    // Bumped on every add/edit/remove of a plane
+    unsigned long constraintsRevision = 0;
+    // Bumped whenever the solution changes, be it a new one, a new optimum or an error
+    unsigned long solutionRevision = 0;
+    SolvedState solvedState;
+    SolvedState pendingState;
+    std::unique_ptr<SolutionCache> solutionCache;
+    SolutionKey pendingKey;
+    uint64_t lastRegionId = 0;
+
+    Snapshot takeSnapshot();
+    static Snapshot presolve(const Snapshot& snapshot, std::vector<uint32_t>& keptPlanes, std::vector<uint32_t>& redundantPlanes);
+    static Solution solveSnapshot(const Snapshot& snapshot);
+    static bool solveSeidel(const Snapshot& snapshot, Solution& solution);
+    static std::vector<glm::dvec4> getHalfspaces(const std::vector<Equation>& planeEquations);
+    static std::vector<ConstraintClass> classifyRows(const std::vector<Equation>& planeEquations, int threadCount, bool isDroppingOnly);
+    static void classifyWithCddlib(const std::vector<Equation>& planeEquations, std::vector<ConstraintClass>& classes);
+    bool solveObjectiveOnly();
+    bool isCachingSolutions() const;
+    SolutionKey getSolutionKey() const;
+    bool solveFromCache(const SolutionKey& key, const SolvedState& state);
+    void publishSolution(const SolutionKey& key, const SolvedState& state);
+    void removeDense(int planeIndex);
 
     protected:
-    std::vector<int> pointlessEquations; // Basically all zeroes
+    std::vector<PlaneHandle> pointlessEquations; // Basically all zeroes
     std::vector<Equation> planeEquations;
     Solution solution;
 
-    void collectPointless();
-
     // virtual "events" for Display compatibility
     virtual void onSolutionSolved() {};
+    virtual void onOptimumUpdated() {}; // Same region, just a different optimum
     virtual void onPlaneAdded(int planeIndex) {};
     virtual void onPlaneUpdated(int planeIndex) {};
+    // The last plane gets moved into planeIndex to fill the gap, mirror that
     virtual void onPlaneRemoved(int planeIndex) {};
+    // Batch removal from collectPointless(): plane i is now what used to be survivors[i], order kept
+    virtual void onPlanesCompacted(const std::vector<int>& survivors) {};
     virtual void onReset() {};
 
     public:
     glm::vec4 objectiveFunction;
     bool doMinimize = true;
+    SolverEngine engine = SolverEngine::ENGINE_CDDLIB;
+    EnumerationEngine enumeration = EnumerationEngine::ENUMERATION_DUAL_HULL;
+    /**
+     * Have presolve throw out rows that don't touch the region at all, before any vertex enumeration.
+     * Costs a small LP per row on every solve, spread over up to two threads (one under 512 rows),
+     * each with a copy of all the rows.
+     */
+    bool dropRedundantRows = false;
 
     LinearProgrammingProblem();
 
-    int getEquationCount();
+    int getEquationCount() const;
+    void collectPointless();
 
-    int addLimitPlane(glm::vec4 constraints);
-    int addLimitPlane(glm::vec4 constraints, EquationType equationType);
+    PlaneHandle addLimitPlane(glm::vec4 constraints);
+    PlaneHandle addLimitPlane(glm::vec4 constraints, EquationType equationType);
     int addLimitPlane(Equation equation);
+    PlaneHandle getPlaneHandle(int planeIndex) const;
+    int getPlaneIndex(PlaneHandle handle) const;
+    bool isValid(PlaneHandle handle) const;
     Equation getLimitPlane(int planeIndex);
+    Equation getLimitPlane(PlaneHandle handle);
     void editLimitPlane(int planeIndex, glm::vec4 constraints);
     void editLimitPlane(int planeIndex, glm::vec4 constraints, EquationType equationType);
+    void editLimitPlane(PlaneHandle handle, glm::vec4 constraints, EquationType equationType);
     void editLimitPlane(Equation equation);
     void removeLimitPlane();
     void removeLimitPlane(int planeIndex);
+    void removeLimitPlane(PlaneHandle handle);
     void reset();
 
     void solve();
+    bool solveAsync();
+    bool pollSolution();
+    bool isSolving() const;
 
     bool isSolved();
     const Solution* getSolution();
+    // Changes whenever the planes or the solution do, compare against an older one to see if anything happened
+    unsigned long getRevision() const;
+    // Same, but for the planes alone. A new solution or optimum leaves it be
+    unsigned long getConstraintsRevision() const;
 
-    virtual ~LinearProgrammingProblem();
-};
-
-#ifdef DISPLAY_IMPL
-class Display:public LinearProgrammingProblem {
-    private:
-    std::shared_ptr<Object> planeObject;
-    std::shared_ptr<Shader> planeShader;
-
-    std::shared_ptr<Object> vectorDisplay;
+    /**
+     * Caps the solution cache at roughly this many bytes, evicting whatever doesn't fit anymore.
+     * 0 turns it off. Solves that land on a system solved before (same planes, any order or scale,
+     * same objective and engines) get the stored solution back instead of a fresh one.
+     */
+    void setSolutionCacheCapacity(size_t bytes);
+    SolutionCacheStats getSolutionCacheStats() const;
 
-    std::shared_ptr<Shader> solutionShader;
-    std::shared_ptr<Object> solutionObject;
-    std::shared_ptr<Object> solutionWireframe;
-    std::vector<glm::mat4> planeTransforms;
+    /**
+     * Sorts every plane into binding, redundant or implicit equality, one entry per plane.
+     * That's one small LP per plane (two for equalities and, on flat regions, for implicit equalities),
+     * run with Seidel over threadCount threads, 0 being one per core. Whatever Seidel can't call
+     * goes through cddlib's own checks instead, if there's cddlib.
+     * Each verdict is about that plane alone: of two identical planes both come back redundant,
+     * since either one can go, just not both at once.
+     */
+    std::vector<ConstraintClass> classifyConstraints(int threadCount = 0) const;
+    /**
+     * classifyConstraints() over a copy of the planes, on a thread of its own, so edits can carry on meanwhile.
+     * The cddlib part queues up behind any solve in flight, which is why the UI goes through this one.
+     */
+    std::future<std::vector<ConstraintClass>> classifyConstraintsAsync(int threadCount = 0) const;
 
-    glm::mat4 optimalPlanTransform;
-    glm::mat4 globalScaleTransform = glm::mat4(1);
+    /**
+     * Solves count independent problems on threadCount threads (0 is one per core) and writes
+     * result i for problem i into results, which has to have room for all of them.
+     * Threads start out with equal slices and steal halves off each other once theirs run dry.
+     * Seidel's answers go straight into results, out of scratch each thread keeps between problems,
+     * so once that's warmed up there's no allocating. Only problems that go to cddlib (asked for,
+     * or Seidel wasn't sure) take the full solve, Solution and all, queued up on cddlib's lock.
+     * Nothing is thrown over a single broken problem, that one just comes back as BATCH_ERROR.
+     */
+    static void solveBatch(const BatchProblem* problems, size_t count, BatchResult* results,
+                           int threadCount = 0, SolverEngine engine = SolverEngine::ENGINE_SEIDEL);
 
-    void createObjects();
-    void createShaders();
-
-    void recalculatePlane(int planeIndex);
-    void recalculateOptimalPlan();
-    void rebindAttributes();
-    void onSolutionSolved();
-    void onPlaneAdded(int planeIndex);
-    void onPlaneUpdated(int planeIndex);
-    void onPlaneRemoved(int planeIndex);
-    void onReset();
-
-    public:
-    std::vector<bool> visibleEquations;
-    bool showPlanesAtAll = true;
-    bool showSolutionVolume = true;
-    bool showSolutionVector = true;
-    bool showSolutionWireframe = true;
-    double globalScale = 1.0;
-    float stripeFrequency = 15.0;
-    float stripeWidth = 0.20;
-    float wireThickness = 5.0;
-    float vectorWidth = 0.04;
-    float arrowScale = 2.5;
-
-    std::vector<glm::vec3> constraintPositiveColors = {
-        {0.9608, 0.7294, 0.4510}, // {0.9216, 0.2863, 0.4627},
-        {0.5843, 0.3529, 0.9608}, // {0.1922, 0.3647, 0.9216},
-        {0.2118, 0.6588, 0.3059}  // {0.9216, 0.6980, 0.1020},
-                                  // {0.1490, 0.9216, 0.2431}
-    };
-    glm::vec3 solutionColor = {1.0, 0.746282, 0.043526};
-    glm::vec3 solutionVectorColor = { 0, 0, 0 }; // {0.128, 0.833, 0.272};
-    glm::vec3 solutionWireframeColor = {0.8, 0.095672, 0.019807};
-
-    Display();
-
-    void setScale(double scale);
-    void render(Camera* camera);
-
-    ~Display();
-};
-
-class WorldGridDisplay {
-    private:
-    std::shared_ptr<Object> gridObject;
-    std::shared_ptr<Object> axisObject;
-    std::shared_ptr<Shader> gridShader;
-    std::shared_ptr<Shader> axisShader;
-    int scaleExponent = 0;
-
-    void createObjects();
-    void createShaders();
-
-    public:
-    bool gridEnabled = true;
-    bool axisEnabled = true;
-
-    float gridScale = 1.0;
-    float gridWidth = 0.05;
-
-    WorldGridDisplay();
-
-    void zoomGrid(float zoomAmount);
-    double getComputedScale();
-    void render(glm::mat4 view, glm::mat4 projection);
-
-    ~WorldGridDisplay();
+    virtual ~LinearProgrammingProblem();
 };
-#endif
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * [begin, end) of indices, packed into one word so that the owner taking one off the front
+ * and a thief taking half off the back are both a single compare-and-swap.
+ * Empty ranges are never swapped against, so there's no ABA to worry about: a range only
+ * ever gets refilled by its owner, through reset().
+ */
+class WorkRange {
+    private:
+    std::atomic<uint64_t> range { 0 };
+
+    static uint64_t pack(uint32_t begin, uint32_t end) { return (static_cast<uint64_t>(begin) << 32) | end; }
+    static uint32_t beginOf(uint64_t packed) { return static_cast<uint32_t>(packed >> 32); }
+    static uint32_t endOf(uint64_t packed) { return static_cast<uint32_t>(packed); }
+
+    public:
+    void reset(uint32_t begin, uint32_t end) { range.store(pack(begin, end), std::memory_order_release); }
+
+    bool take(uint32_t& index) {
+        uint64_t current = range.load(std::memory_order_acquire);
+        while (beginOf(current) < endOf(current)) {
+            if (range.compare_exchange_weak(current, pack(beginOf(current) + 1, endOf(current)), std::memory_order_acq_rel)) {
+                index = beginOf(current);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Rounded up, so a lone index left behind a slow one still gets picked up
+    bool steal(uint32_t& begin, uint32_t& end) {
+        uint64_t current = range.load(std::memory_order_acquire);
+        while (beginOf(current) < endOf(current)) {
+            uint32_t half = (endOf(current) - beginOf(current) + 1) / 2;
+            uint32_t split = endOf(current) - half;
+            if (range.compare_exchange_weak(current, pack(beginOf(current), split), std::memory_order_acq_rel)) {
+                begin = split;
+                end = endOf(current);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// A line's worth apart, threads hammering neighbouring ranges would just fight over the cache line.
+// Padding rather than alignas, over-aligned new is C++17
+struct PaddedRange {
+    WorkRange range;
+    char padding[64 - sizeof(WorkRange)];
+};
+
+// How many threads forEachStealing() is going to use: 0 is one per core, and never more than there's work for
+inline int getWorkerCount(uint32_t count, int threadCount) {
+    if (threadCount <= 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    return static_cast<int>(std::max<uint32_t>(1, std::min<uint32_t>(threadCount, count)));
+}
+
+/**
+ * Calls work(worker, index) once for every index in [0, count), over getWorkerCount() threads,
+ * the calling one included. worker is which thread it is, counted from 0, so per-thread scratch
+ * can be set up beforehand. Threads start out with equal slices and steal halves off each other
+ * once theirs run dry. Returns once everything's done.
+ */
+template <typename Work>
+void forEachStealing(uint32_t count, int threadCount, Work work) {
+    if (count == 0) return;
+    threadCount = getWorkerCount(count, threadCount);
+    std::unique_ptr<PaddedRange[]> ranges(new PaddedRange[threadCount]);
+    for (int thread = 0; thread < threadCount; thread++) {
+        ranges[thread].range.reset(uint64_t(count) * thread / threadCount, uint64_t(count) * (thread + 1) / threadCount);
+    }
+
+    auto worker = [&](int self) {
+        WorkRange& ownRange = ranges[self].range;
+        while (true) {
+            uint32_t index;
+            if (!ownRange.take(index)) {
+                // Out of our own, go look for someone who isn't
+                bool hasStolen = false;
+                for (int offset = 1; offset < threadCount && !hasStolen; offset++) {
+                    uint32_t begin, end;
+                    if (ranges[(self + offset) % threadCount].range.steal(begin, end)) {
+                        ownRange.reset(begin, end);
+                        hasStolen = true;
+                    }
+                }
+                if (!hasStolen) return; // Everything left is already being worked on
+                continue;
+            }
+            work(self, index);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (int thread = 1; thread < threadCount; thread++) threads.emplace_back(worker, thread);
+    worker(0); // Calling thread pulls its weight too
+    for (std::thread& thread : threads) thread.join();
+}
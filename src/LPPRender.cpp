@@ -0,0 +1,546 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <glad/glad.h>
+
+#include "assets.h"
+#include "camera.h"
+#include "display.h"
+#include "generators.h"
+#include "problem.h"
+#include "profiler.h"
+#include "pngwriter.h"
+#include "config.h"
+
+/**
+ * LPPRender: LPPShow without the window. Reads problems, solves them and writes out PNGs,
+ * one per problem per view. Runs on EGL, so Mesa's llvmpipe does the job on GPU-less boxes
+ * (EGL_PLATFORM=surfaceless if there's no display server around either).
+ *
+ * The frame goes into an offscreen FBO, then into one of two pixel pack buffers. That one only
+ * gets mapped after the next frame has been issued, so the GPU copies while we're off solving the
+ * next problem. PNG encoding happens on its own thread after that.
+ *
+ * --frame-time draws every view that many more times before the picture, and prints what a frame cost.
+ * --sphere makes up a problem with that many planes instead of (or on top of) reading one, so there's
+ * always something to time against: "LPPRender --sphere 256 --frame-time 1000 --no-grid".
+ * Add --uniform-lookups for the same frames with every uniform looked up by name, the way it was
+ * before Shader cached locations.
+ */
+
+const glm::vec3 worldColor = { 0.364, 0.674, 0.764 }; // Same as LPPShow's
+
+namespace Options {
+    int width = 1280;
+    int height = 720;
+    int samples = 4;
+    bool showGrid = true;
+    bool printStats = false;
+    int timedFrames = 0;
+    int spherePlanes = 0;
+    bool isLookingUpUniforms = false;
+    SolverEngine engine = SolverEngine::ENGINE_CDDLIB;
+    std::string outputDirectory = ".";
+    std::vector<CameraView> views = { VIEW_DEFAULT };
+    std::vector<std::string> problemFiles;
+}
+
+const char* const viewNames[4] = { "default", "top", "left", "right" };
+
+struct EncodeJob {
+    std::string path;
+    std::vector<unsigned char> pixels;
+};
+
+// One thread, one queue. PNGs come out in the order they went in.
+// Deflate is way slower than llvmpipe, so push() waits once MAX_PENDING frames are queued up
+class Encoder {
+    private:
+    static const size_t MAX_PENDING = 4;
+
+    std::mutex queueLock;
+    std::condition_variable queueChanged;
+    std::condition_variable queueFreed;
+    std::deque<EncodeJob> queue;
+    bool isFinishing = false;
+    std::thread worker;
+
+    void run() {
+        while (true) {
+            EncodeJob job;
+            {
+                std::unique_lock<std::mutex> lock(queueLock);
+                queueChanged.wait(lock, [this]() { return isFinishing || !queue.empty(); });
+                if (queue.empty()) return;
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            queueFreed.notify_one();
+            // GL hands rows over bottom to top
+            size_t stride = static_cast<size_t>(Options::width) * 4;
+            std::vector<unsigned char> row(stride);
+            for (int top = 0, bottom = Options::height - 1; top < bottom; top++, bottom--) {
+                std::memcpy(row.data(), &job.pixels[stride * top], stride);
+                std::memcpy(&job.pixels[stride * top], &job.pixels[stride * bottom], stride);
+                std::memcpy(&job.pixels[stride * bottom], row.data(), stride);
+            }
+            try {
+                writePNG(job.path, Options::width, Options::height, job.pixels.data());
+                std::cout << job.path << std::endl;
+            } catch (std::runtime_error &error) {
+                std::cerr << error.what() << std::endl;
+                failedCount++;
+            }
+        }
+    }
+
+    public:
+    int failedCount = 0; // Only to be read after finish()
+
+    Encoder() { worker = std::thread(&Encoder::run, this); }
+
+    void push(EncodeJob&& job) {
+        {
+            std::unique_lock<std::mutex> lock(queueLock);
+            queueFreed.wait(lock, [this]() { return queue.size() < MAX_PENDING; });
+            queue.push_back(std::move(job));
+        }
+        queueChanged.notify_one();
+    }
+
+    // Drains the queue and waits for it
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(queueLock);
+            isFinishing = true;
+        }
+        queueChanged.notify_one();
+        if (worker.joinable()) worker.join();
+    }
+
+    ~Encoder() { finish(); }
+};
+
+class OffscreenTarget {
+    private:
+    GLuint framebuffer = 0;
+    GLuint colorBuffer = 0;
+    GLuint depthBuffer = 0;
+    // Multisampled buffers can't be read from, so they get resolved into these first
+    GLuint resolveFramebuffer = 0;
+    GLuint resolveColorBuffer = 0;
+
+    GLuint packBuffers[2] = { 0, 0 };
+    std::string packedPaths[2];
+    int nextPackBuffer = 0;
+
+    void collect(int packBuffer, Encoder& encoder) {
+        if (packedPaths[packBuffer].empty()) return;
+        size_t imageSize = static_cast<size_t>(Options::width) * Options::height * 4;
+        EncodeJob job;
+        job.path = std::move(packedPaths[packBuffer]);
+        job.pixels.resize(imageSize);
+        packedPaths[packBuffer].clear();
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffers[packBuffer]);
+        const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, imageSize, GL_MAP_READ_BIT);
+        if (pixels == nullptr) throw std::runtime_error("Failed to map a pixel buffer");
+        std::memcpy(job.pixels.data(), pixels, imageSize);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        encoder.push(std::move(job));
+    }
+
+    public:
+    OffscreenTarget(int width, int height, int samples) {
+        glGenFramebuffers(1, &framebuffer);
+        glGenRenderbuffers(1, &colorBuffer);
+        glGenRenderbuffers(1, &depthBuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            throw std::runtime_error("Offscreen framebuffer is incomplete");
+
+        if (samples > 0) {
+            glGenFramebuffers(1, &resolveFramebuffer);
+            glGenRenderbuffers(1, &resolveColorBuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, resolveFramebuffer);
+            glBindRenderbuffer(GL_RENDERBUFFER, resolveColorBuffer);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolveColorBuffer);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                throw std::runtime_error("Resolve framebuffer is incomplete");
+        }
+
+        glGenBuffers(2, packBuffers);
+        for (GLuint packBuffer : packBuffers) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffer);
+            glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<size_t>(width) * height * 4, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, width, height);
+    }
+
+    void bind() { glBindFramebuffer(GL_FRAMEBUFFER, framebuffer); }
+
+    /**
+     * Starts copying the frame out without waiting for it, then hands the previous one to the encoder.
+     * That one's had a whole solve and render to finish copying, so mapping it shouldn't block.
+     */
+    void readback(const std::string& path, Encoder& encoder) {
+        GLuint source = framebuffer;
+        if (resolveFramebuffer != 0) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFramebuffer);
+            glBlitFramebuffer(0, 0, Options::width, Options::height, 0, 0, Options::width, Options::height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            source = resolveFramebuffer;
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffers[nextPackBuffer]);
+        glReadPixels(0, 0, Options::width, Options::height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        packedPaths[nextPackBuffer] = path;
+
+        nextPackBuffer ^= 1;
+        collect(nextPackBuffer, encoder);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    }
+
+    // Whatever's still in flight goes to the encoder
+    void flush(Encoder& encoder) {
+        collect(nextPackBuffer, encoder);
+        collect(nextPackBuffer ^ 1, encoder);
+    }
+
+    ~OffscreenTarget() {
+        glDeleteBuffers(2, packBuffers);
+        glDeleteRenderbuffers(1, &colorBuffer);
+        glDeleteRenderbuffers(1, &depthBuffer);
+        glDeleteFramebuffers(1, &framebuffer);
+        if (resolveFramebuffer != 0) {
+            glDeleteRenderbuffers(1, &resolveColorBuffer);
+            glDeleteFramebuffers(1, &resolveFramebuffer);
+        }
+    }
+};
+
+void printUsage(const char* executable) {
+    std::cerr << "Usage: " << executable << " [options] problem files...\n"
+              << "  --size WxH          image size, 1280x720 by default\n"
+              << "  --views a,b,..      any of default, top, left, right. Just default if not given\n"
+              << "  --output DIR        where the images go, current directory by default\n"
+              << "  --samples N         multisampling, 4 by default, 0 to turn off\n"
+              << "  --engine NAME       cddlib or seidel\n"
+              << "  --no-grid           leave out the world grid and the axes\n"
+              << "  --stats             print each solve's counts and stage timings to stdout\n"
+              << "  --frame-time N      draw each view N more times first, print CPU and GPU time per frame\n"
+              << "  --sphere N          also render N planes tangent to the unit sphere, as sphere-N\n"
+              << "  --uniform-lookups   look uniforms up by name on every set, like before the location cache\n"
+              << "Images are named <problem>[-<index>]-<view>.png, index only for files with several problems.\n"
+              << "No display server? Run with EGL_PLATFORM=surfaceless." << std::endl;
+}
+
+bool parseArguments(int argc, char** argv) {
+    for (int argument = 1; argument < argc; argument++) {
+        std::string option = argv[argument];
+        bool hasValue = argument + 1 < argc;
+        if (option == "--size" && hasValue) {
+            if (std::sscanf(argv[++argument], "%dx%d", &Options::width, &Options::height) != 2
+             || Options::width <= 0 || Options::height <= 0) return false;
+        } else if (option == "--views" && hasValue) {
+            Options::views.clear();
+            std::string views = argv[++argument];
+            size_t start = 0;
+            while (start <= views.size()) {
+                size_t end = views.find(',', start);
+                if (end == std::string::npos) end = views.size();
+                std::string name = views.substr(start, end - start);
+                int view = 0;
+                while (view < 4 && name != viewNames[view]) view++;
+                if (view == 4) return false;
+                Options::views.push_back(static_cast<CameraView>(view));
+                start = end + 1;
+            }
+        } else if (option == "--output" && hasValue) {
+            Options::outputDirectory = argv[++argument];
+        } else if (option == "--samples" && hasValue) {
+            Options::samples = std::atoi(argv[++argument]);
+            if (Options::samples < 0) return false;
+        } else if (option == "--engine" && hasValue) {
+            std::string engine = argv[++argument];
+            if (engine == "cddlib") Options::engine = SolverEngine::ENGINE_CDDLIB;
+            else if (engine == "seidel") Options::engine = SolverEngine::ENGINE_SEIDEL;
+            else return false;
+        } else if (option == "--no-grid") {
+            Options::showGrid = false;
+        } else if (option == "--stats") {
+            Options::printStats = true;
+        } else if (option == "--frame-time" && hasValue) {
+            Options::timedFrames = std::atoi(argv[++argument]);
+            if (Options::timedFrames <= 0) return false;
+        } else if (option == "--uniform-lookups") {
+            Options::isLookingUpUniforms = true;
+        } else if (option == "--sphere" && hasValue) {
+            Options::spherePlanes = std::atoi(argv[++argument]);
+            if (Options::spherePlanes <= 0) return false;
+        } else if (option.size() > 1 && option[0] == '-') {
+            return false;
+        } else {
+            Options::problemFiles.push_back(option);
+        }
+    }
+    return !Options::problemFiles.empty() || Options::spherePlanes > 0;
+}
+
+// "some/where/cube.lpp" -> "cube"
+std::string problemName(const std::string& path) {
+    size_t start = path.find_last_of("/\\");
+    start = (start == std::string::npos) ? 0 : start + 1;
+    size_t end = path.find_last_of('.');
+    if (end == std::string::npos || end < start) end = path.size();
+    return path.substr(start, end - start);
+}
+
+/**
+ * "cube: 6 rows (0 redundant), 8 vertices, 0 rays, 12 edges, 6 faces; 41.2 us (seidel 3.1, ...)"
+ * Put together first and written in one go, the encoder prints to stdout from its own thread.
+ */
+void printStats(const std::string& name, const SolveStats& stats) {
+    char buffer[128];
+    std::snprintf(buffer, sizeof(buffer), ": %u rows (%u redundant), %u vertices, %u rays, %u edges, %u faces",
+        stats.rowCount, stats.redundantRowCount, stats.vertexCount, stats.rayCount, stats.edgeCount, stats.facetCount);
+    std::string line = name + buffer;
+    if (stats.hasTimings) {
+        std::snprintf(buffer, sizeof(buffer), "; %.1f us (", stats.getTotalMicroseconds());
+        line += buffer;
+        const char* separator = "";
+        for (int stage = 0; stage < SOLVE_STAGE_COUNT; stage++) {
+            if (stats.stageMicroseconds[stage] == 0) continue;
+            std::snprintf(buffer, sizeof(buffer), "%s%s %.1f", separator, SolveStats::getStageName(static_cast<SolveStage>(stage)), stats.stageMicroseconds[stage]);
+            line += buffer;
+            separator = ", ";
+        }
+        line += ')';
+    }
+    line += '\n';
+    std::fputs(line.c_str(), stdout);
+}
+
+/**
+ * Draws the frame Options::timedFrames times and prints the average.
+ * CPU is issuing the frame, render() calls and all. glFinish() after each one keeps the GPU
+ * from falling behind and isn't counted. GPU and the per-section split come from a FrameProfiler
+ * of its own, over the last HISTORY_SIZE of these frames.
+ * "sphere-256-default: 256 planes, 1000 frames, CPU 0.412 ms/frame (World grid 0.020, ...), GPU 1.702 ms/frame"
+ */
+template <typename DrawFrame>
+void timeFrames(const std::string& name, Display& lppshow, WorldGridDisplay& worldOrigin, DrawFrame drawFrame) {
+    FrameProfiler profiler;
+    profiler.isEnabled = true;
+    lppshow.profiler = &profiler;
+    worldOrigin.profiler = &profiler;
+    double cpuMilliseconds = 0;
+    for (int frame = 0; frame < Options::timedFrames; frame++) {
+        profiler.newFrame();
+        auto start = std::chrono::steady_clock::now();
+        drawFrame();
+        cpuMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        profiler.endFrame();
+        glFinish();
+    }
+    profiler.newFrame(); // Picks up the last frame's GPU times
+    lppshow.profiler = nullptr;
+    worldOrigin.profiler = nullptr;
+
+    char buffer[128];
+    std::snprintf(buffer, sizeof(buffer), ": %d planes, %d frames, CPU %.3f ms/frame (",
+        lppshow.getEquationCount(), Options::timedFrames, cpuMilliseconds / Options::timedFrames);
+    std::string line = name + buffer;
+    float gpuMilliseconds = 0;
+    const char* separator = "";
+    for (int section = PROFILE_GRID; section <= PROFILE_SOLUTION; section++) {
+        ProfileSection profiled = static_cast<ProfileSection>(section);
+        gpuMilliseconds += profiler.getAverageGPU(profiled);
+        std::snprintf(buffer, sizeof(buffer), "%s%s %.3f", separator, FrameProfiler::getSectionName(profiled), profiler.getAverageCPU(profiled));
+        line += buffer;
+        separator = ", ";
+    }
+    std::snprintf(buffer, sizeof(buffer), "), GPU %.3f ms/frame\n", gpuMilliseconds);
+    line += buffer;
+    std::fputs(line.c_str(), stdout);
+}
+
+int logCriticalError(const char* description) {
+    std::cerr << "Critical: " << description << std::endl;
+    return -1;
+}
+
+int main(int argc, char** argv) {
+    if (!parseArguments(argc, argv)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    ////////////
+    //// INIT EGL
+    ////////////
+    EGLDisplay eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint eglMajor, eglMinor;
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &eglMajor, &eglMinor))
+        return logCriticalError("Failed to initialize EGL");
+
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig eglConfig;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(eglDisplay, configAttributes, &eglConfig, 1, &configCount) || configCount == 0)
+        return logCriticalError("No EGL config for desktop OpenGL");
+
+    // We never draw to it, it's only there for drivers that don't do surfaceless contexts
+    const EGLint surfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    EGLSurface eglSurface = eglCreatePbufferSurface(eglDisplay, eglConfig, surfaceAttributes);
+
+    eglBindAPI(EGL_OPENGL_API);
+    // OpenGL 3.3 core, same as LPPShow
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext eglContext = eglCreateContext(eglDisplay, eglConfig, EGL_NO_CONTEXT, contextAttributes);
+    if (eglContext == EGL_NO_CONTEXT || !eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext))
+        return logCriticalError("Failed to get an OpenGL 3.3 context");
+    if (!gladLoadGLLoader((GLADloadproc) eglGetProcAddress)) return logCriticalError("Failed to load OpenGL");
+
+    glEnable(GL_DEPTH_TEST);
+    glFrontFace(GL_CW);
+
+    int failedCount = 0;
+    try {
+    // All of these hold GL objects, so they have to be gone before the context is
+    std::unique_ptr<Display> lppshow;
+    std::unique_ptr<WorldGridDisplay> worldOrigin;
+    try {
+        lppshow.reset(new Display());
+        worldOrigin.reset(new WorldGridDisplay());
+    } catch (std::exception &ioerr) {
+        throw std::runtime_error("Failed to compile required shaders");
+    }
+    Shader::isLookingUpEveryCall = Options::isLookingUpUniforms;
+    lppshow->engine = Options::engine;
+    lppshow->setSolutionCacheCapacity(0); // One solve per problem file, nothing to hit
+    UniformBuffer cameraBuffer(sizeof(CameraBlock), UNIFORM_BLOCK_CAMERA);
+    OffscreenTarget target(Options::width, Options::height, Options::samples);
+    Encoder encoder;
+    Camera camera(Options::width, Options::height);
+
+    // Whatever's in lppshow right now: solved, then a picture per view
+    auto renderProblem = [&](const std::string& source, const std::string& imageName) {
+        try {
+            lppshow->solve();
+            if (Options::printStats) printStats(imageName, lppshow->getSolution()->stats);
+        } catch (std::runtime_error &error) {
+            // Still worth a picture, the planes are there even if the region isn't
+            std::cerr << source << " (" << imageName << "): " << error.what() << std::endl;
+            failedCount++;
+        }
+
+        for (CameraView view : Options::views) {
+            camera.snapTo(VIEW_DEFAULT); // Resets lookDepth for the ortho ones
+            camera.snapTo(view);
+            auto drawFrame = [&]() {
+                target.bind();
+                glClearColor(worldColor.x, worldColor.y, worldColor.z, 1.0);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                cameraBuffer.update(CameraBlock { camera.getProjection(), camera.getView() });
+                if (Options::showGrid) worldOrigin->render();
+                lppshow->render();
+            };
+            std::string viewName = imageName + "-" + viewNames[view];
+            if (Options::timedFrames > 0) timeFrames(viewName, *lppshow, *worldOrigin, drawFrame);
+            drawFrame();
+            target.readback(Options::outputDirectory + "/" + viewName + ".png", encoder);
+        }
+    };
+
+    for (const std::string& problemFile : Options::problemFiles) {
+        std::ifstream input(problemFile);
+        if (!input) {
+            std::cerr << problemFile << ": can't open" << std::endl;
+            failedCount++;
+            continue;
+        }
+        std::string name = problemName(problemFile);
+
+        // Quick pass to count them, names only get indices when there's more than one
+        int problemCount = 0;
+        {
+            LinearProgrammingProblem counter;
+            int lineNumber = 0;
+            try { while (readProblem(input, counter, lineNumber)) problemCount++; }
+            catch (std::runtime_error &error) { problemCount++; } // The broken one still gets reported below
+            input.clear();
+            input.seekg(0);
+        }
+
+        int lineNumber = 0;
+        for (int problemIndex = 0; problemIndex < problemCount; problemIndex++) {
+            try {
+                if (!readProblem(input, *lppshow, lineNumber)) break;
+            } catch (std::runtime_error &error) {
+                std::cerr << problemFile << ": " << error.what() << std::endl;
+                failedCount++;
+                break; // No telling where the next problem starts
+            }
+            std::string imageName = problemCount == 1 ? name : name + "-" + std::to_string(problemIndex);
+            renderProblem(problemFile, imageName);
+        }
+    }
+
+    if (Options::spherePlanes > 0) {
+        lppshow->reset();
+        makeSphere(lppshow.get(), Options::spherePlanes);
+        std::string name = "sphere-" + std::to_string(Options::spherePlanes);
+        renderProblem(name, name);
+    }
+
+    target.flush(encoder);
+    encoder.finish();
+    failedCount += encoder.failedCount;
+    } catch (std::runtime_error &error) {
+        std::cerr << "Critical: " << error.what() << std::endl;
+        failedCount++;
+    }
+
+    eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(eglDisplay, eglContext);
+    if (eglSurface != EGL_NO_SURFACE) eglDestroySurface(eglDisplay, eglSurface);
+    eglTerminate(eglDisplay);
+    return failedCount == 0 ? 0 : 2;
+}
@@ -1,3 +1,4 @@
+#include <chrono>
 #include <iostream>
 #include <vector>
 #include <memory>
@@ -9,11 +10,11 @@
 #include <imgui/backends/imgui_impl_opengl3.h>
 
 #define LOCALMAN_IMPL
-#define DISPLAY_IMPL
 #include "localman.h"
 #include "assets.h"
 #include "camera.h"
-#include "solver.h"
+#include "display.h"
+#include "profiler.h"
 #include "config.h"
 
 // *honestly* i should define a function doing the same as '_' from moFileReader (mfr for short)
@@ -46,11 +47,35 @@ namespace SceneData {
     bool canMoveCamera = true;
     bool allowEditCamera = false;
     bool showDebugOverlay = false;
+    bool showProfiler = false;
     Display* lppshow;
     WorldGridDisplay* worldOrigin;
     Camera *sceneCamera;
+    UniformBuffer* cameraBuffer;
+    FrameProfiler* profiler;
+    // Sleep between events instead of drawing every vsync
+    bool renderOnDemand = true;
+    bool hasPendingInput = true;
+    // One per plane, redone off the GL thread whenever the planes change while highlighting is on
+    bool highlightRedundant = false;
+    std::vector<ConstraintClass> constraintClasses;
+    unsigned long constraintClassesRevision = ~0ul; // Planes constraintClasses were worked out for
+    std::future<std::vector<ConstraintClass>> pendingClasses;
+    unsigned long classifiedRevision = ~0ul; // Planes that went into pendingClasses, or the last one that did
 }
 
+// Render on demand: how many frames to keep drawing after the last change, ImGui needs a couple to settle hovers and such
+const int FRAMES_AFTER_CHANGE = 3;
+// Nothing sends us events when a background solve or classification finishes, so we peek this often while it runs
+const double SOLVING_WAKE_INTERVAL = 1.0 / 30.0;
+const double IDLE_WAKE_INTERVAL = 0.5;
+const int cameraKeys[] = {
+    GLFW_KEY_LEFT, GLFW_KEY_RIGHT, GLFW_KEY_UP, GLFW_KEY_DOWN,
+    GLFW_KEY_W, GLFW_KEY_A, GLFW_KEY_S, GLFW_KEY_D,
+    GLFW_KEY_R, GLFW_KEY_F,
+    GLFW_KEY_KP_1, GLFW_KEY_KP_3, GLFW_KEY_KP_7
+};
+
 namespace SettingsWindow {
     bool showSettingsWindow = false;
     int currentTheme = 0;
@@ -98,23 +123,10 @@ void moveCamera(Camera* camera, GLFWwindow* inputWindow, float timeStep) {
     float snapToLeft = glfwGetKey(inputWindow, GLFW_KEY_KP_1);
     float snapToRight = glfwGetKey(inputWindow, GLFW_KEY_KP_3);
 
-    if (snapToRight) {
-        camera->teleportTo(camera->lookDepth, 0, 0);
-        camera->rotate(0, 0, -90);
-        camera->setOrtography();
-    } else if (snapToLeft) {
-        camera->teleportTo(0, -camera->lookDepth, 0);
-        camera->rotate(0, 0, 0);
-        camera->setOrtography();
-    } else if (snapToTop) {
-        camera->teleportTo(0, 0, camera->lookDepth);
-        camera->rotate(-89.9, 0, 0);
-        camera->setOrtography();
-    }
-
-    if (snapToLeft || snapToRight || snapToTop) {
-        camera->setOrtography();
-    } else if (orbitHorizontal || orbitVertical) {
+    if (snapToRight) camera->snapTo(VIEW_RIGHT);
+    else if (snapToLeft) camera->snapTo(VIEW_LEFT);
+    else if (snapToTop) camera->snapTo(VIEW_TOP);
+    else if (orbitHorizontal || orbitVertical) {
         camera->orbit(orbitHorizontal * movementSpeed * speedMod, -orbitVertical * movementSpeed * speedMod);
         camera->setPerspective();
     }
@@ -181,6 +193,18 @@ void show_preferences_window(bool* isOpen) {
             }
             ImGui::EndCombo();
         }
+        ImGui::Checkbox(l10nc("Redraw only on changes"), &SceneData::renderOnDemand);
+        ImGui::Text(l10nc("Solver: ")); ImGui::SameLine();
+        int currentEngine = SceneData::lppshow->engine;
+        if (ImGui::Combo("###engine", &currentEngine, "cddlib\0Seidel\0")) {
+            SceneData::lppshow->engine = static_cast<SolverEngine>(currentEngine);
+        }
+        ImGui::Text(l10nc("Vertex enumeration: ")); ImGui::SameLine();
+        int currentEnumeration = SceneData::lppshow->enumeration;
+        if (ImGui::Combo("###enumeration", &currentEnumeration, "Double description\0Dual hull\0")) {
+            SceneData::lppshow->enumeration = static_cast<EnumerationEngine>(currentEnumeration);
+        }
+        ImGui::Checkbox(l10nc("Drop redundant planes before solving"), &SceneData::lppshow->dropRedundantRows);
     }
     if (SettingsWindow::selected(SettingsWindow::editColors)) {
         ImGuiColorEditFlags shaderPickerFlags = ImGuiColorEditFlags_Float | ImGuiColorEditFlags_NoAlpha | ImGuiColorEditFlags_NoInputs | ImGuiColorEditFlags_NoOptions;
@@ -194,7 +218,8 @@ void show_preferences_window(bool* isOpen) {
         ImGui::ColorEdit3(l10nc("Solution vector"), &SceneData::lppshow->solutionVectorColor.x, shaderPickerFlags);
         for (int colorIndex = 0; colorIndex < SceneData::lppshow->constraintPositiveColors.size(); colorIndex++) {
             ImGui::PushID(colorIndex);
-            ImGui::ColorEdit3(l10nc("Plane color"), &SceneData::lppshow->constraintPositiveColors[colorIndex].x, shaderPickerFlags);
+            if (ImGui::ColorEdit3(l10nc("Plane color"), &SceneData::lppshow->constraintPositiveColors[colorIndex].x, shaderPickerFlags))
+                SceneData::lppshow->invalidatePlaneColors();
             ImGui::PopID();
         }
     }
@@ -226,6 +251,7 @@ void show_preferences_window(bool* isOpen) {
 }
 
 void updateProcessDraw(GLFWwindow* window, Camera* camera, float timeStep) {
+    SceneData::profiler->begin(PROFILE_IMGUI_BUILD);
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
@@ -270,9 +296,9 @@ void updateProcessDraw(GLFWwindow* window, Camera* camera, float timeStep) {
         {
         case 1: // Cube thing
             {
-            SceneData::lppshow->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN); SceneData::lppshow->visibleEquations[0] = false;
-            SceneData::lppshow->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN); SceneData::lppshow->visibleEquations[1] = false;
-            SceneData::lppshow->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN); SceneData::lppshow->visibleEquations[2] = false;
+            SceneData::lppshow->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN); SceneData::lppshow->setPlaneVisible(0, false);
+            SceneData::lppshow->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN); SceneData::lppshow->setPlaneVisible(1, false);
+            SceneData::lppshow->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN); SceneData::lppshow->setPlaneVisible(2, false);
             SceneData::lppshow->addLimitPlane({1, 0, 0, 1});
             SceneData::lppshow->addLimitPlane({0, 1, 0, 1});
             SceneData::lppshow->addLimitPlane({0, 0, 1, 1});
@@ -282,14 +308,14 @@ void updateProcessDraw(GLFWwindow* window, Camera* camera, float timeStep) {
             }
         case 2: // Pyramid thing
             {
-            SceneData::lppshow->addLimitPlane({ 0.5,  0.5,  0.5, 1.0}); SceneData::lppshow->visibleEquations[0] = false;
-            SceneData::lppshow->addLimitPlane({ 0.5, -0.5,  0.5, 1.0}); SceneData::lppshow->visibleEquations[1] = false;
-            SceneData::lppshow->addLimitPlane({-0.5, -0.5,  0.5, 1.0}); // SceneData::lppshow->visibleEquations[2] = false;
-            SceneData::lppshow->addLimitPlane({-0.5,  0.5,  0.5, 1.0}); SceneData::lppshow->visibleEquations[3] = false;
-            SceneData::lppshow->addLimitPlane({ 1.0,  1.0, -0.5, 0.5}); SceneData::lppshow->visibleEquations[4] = false;
-            SceneData::lppshow->addLimitPlane({ 1.0, -1.0, -0.5, 0.5}); // SceneData::lppshow->visibleEquations[5] = false;
-            SceneData::lppshow->addLimitPlane({-1.0, -1.0, -0.5, 0.5}); SceneData::lppshow->visibleEquations[6] = false;
-            SceneData::lppshow->addLimitPlane({-1.0,  1.0, -0.5, 0.5}); // SceneData::lppshow->visibleEquations[7] = false;
+            SceneData::lppshow->addLimitPlane({ 0.5,  0.5,  0.5, 1.0}); SceneData::lppshow->setPlaneVisible(0, false);
+            SceneData::lppshow->addLimitPlane({ 0.5, -0.5,  0.5, 1.0}); SceneData::lppshow->setPlaneVisible(1, false);
+            SceneData::lppshow->addLimitPlane({-0.5, -0.5,  0.5, 1.0}); // SceneData::lppshow->setPlaneVisible(2, false);
+            SceneData::lppshow->addLimitPlane({-0.5,  0.5,  0.5, 1.0}); SceneData::lppshow->setPlaneVisible(3, false);
+            SceneData::lppshow->addLimitPlane({ 1.0,  1.0, -0.5, 0.5}); SceneData::lppshow->setPlaneVisible(4, false);
+            SceneData::lppshow->addLimitPlane({ 1.0, -1.0, -0.5, 0.5}); // SceneData::lppshow->setPlaneVisible(5, false);
+            SceneData::lppshow->addLimitPlane({-1.0, -1.0, -0.5, 0.5}); SceneData::lppshow->setPlaneVisible(6, false);
+            SceneData::lppshow->addLimitPlane({-1.0,  1.0, -0.5, 0.5}); // SceneData::lppshow->setPlaneVisible(7, false);
             SceneData::lppshow->objectiveFunction = { 0, 0, 1, 0 };
             SceneData::lppshow->doMinimize = false;
             break;
@@ -370,6 +396,31 @@ void updateProcessDraw(GLFWwindow* window, Camera* camera, float timeStep) {
     }
     ImGui::Separator();
 
+    // Rows zeroed out with "x" last frame go away here, all at once
+    SceneData::lppshow->collectPointless();
+
+    const ImVec4 redundantColor = {0.5, 0.5, 0.5, 0.35};
+    const ImVec4 implicitEqualityColor = {0.25, 0.45, 0.95, 0.35};
+    ImGui::Checkbox(l10nc("Highlight redundant planes"), &SceneData::highlightRedundant);
+    if (SceneData::pendingClasses.valid() && SceneData::pendingClasses.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        SceneData::constraintClasses = SceneData::pendingClasses.get();
+        SceneData::constraintClassesRevision = SceneData::classifiedRevision;
+        SceneData::hasPendingInput = true; // Nothing else is going to wake us up to show them
+    }
+    if (SceneData::highlightRedundant) {
+        // cddlib's half of it waits out any solve in flight, so never here. One at a time: a drag gets caught up on the next round
+        const unsigned long constraintsRevision = SceneData::lppshow->getConstraintsRevision();
+        if (!SceneData::pendingClasses.valid() && SceneData::classifiedRevision != constraintsRevision) {
+            SceneData::pendingClasses = SceneData::lppshow->classifyConstraintsAsync();
+            SceneData::classifiedRevision = constraintsRevision;
+        }
+        ImGui::SameLine(); ImGui::TextColored({redundantColor.x, redundantColor.y, redundantColor.z, 1}, l10nc("Redundant"));
+        ImGui::SameLine(); ImGui::TextColored({implicitEqualityColor.x, implicitEqualityColor.y, implicitEqualityColor.z, 1}, l10nc("Implicit equality"));
+    }
+
+    // Older verdicts would land on whatever rows moved into their place, better none until the new ones are in
+    if (SceneData::constraintClassesRevision != SceneData::lppshow->getConstraintsRevision()) SceneData::constraintClasses.clear();
+
     float TEXT_BASE_WIDTH = ImGui::GetTextLineHeightWithSpacing();
     ImVec2 tableSize = ImVec2(0.0f, TEXT_BASE_WIDTH * 8);
     ImGuiTableFlags tableFlags = ImGuiTableFlags_BordersOuter | ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersH | ImGuiTableFlags_ScrollY | ImGuiTableFlags_NoPadInnerX;
@@ -393,10 +444,16 @@ void updateProcessDraw(GLFWwindow* window, Camera* camera, float timeStep) {
 
 
         // ImGui::
-        for (int planeIndex = 0; planeIndex < SceneData::lppshow->getEquationCount(); planeIndex++) {
+        const int equationCount = SceneData::lppshow->getEquationCount();
+        for (int planeIndex = 0; planeIndex < equationCount; planeIndex++) {
             ImGui::TableNextRow();
             ImGui::TableNextColumn();
             auto planeEquationOrigin = SceneData::lppshow->getLimitPlane(planeIndex);
+            if (SceneData::highlightRedundant && planeIndex < static_cast<int>(SceneData::constraintClasses.size())) {
+                ConstraintClass constraintClass = SceneData::constraintClasses[planeIndex];
+                if (constraintClass == CONSTRAINT_REDUNDANT) ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1, ImGui::GetColorU32(redundantColor));
+                if (constraintClass == CONSTRAINT_IMPLICIT_EQUALITY) ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1, ImGui::GetColorU32(implicitEqualityColor));
+            }
             ImGui::PushID(planeIndex);
             if (ImGui::Button("x")) SceneData::lppshow->editLimitPlane(planeIndex, {0, 0, 0, 0});
             ImGui::TableNextColumn();
@@ -435,9 +492,8 @@ void updateProcessDraw(GLFWwindow* window, Camera* camera, float timeStep) {
             ImGui::TableNextColumn();
             ImGui::PopStyleColor();
 
-            // XXX: Do we want to use std::vector<bool> optimization or fall back to Plane objects?
-            bool isVisible = SceneData::lppshow->visibleEquations[planeIndex];
-            if(ImGui::Checkbox("##vis", &isVisible)) SceneData::lppshow->visibleEquations[planeIndex] = isVisible;
+            bool isVisible = SceneData::lppshow->isPlaneVisible(planeIndex);
+            if(ImGui::Checkbox("##vis", &isVisible)) SceneData::lppshow->setPlaneVisible(planeIndex, isVisible);
             ImGui::TableNextColumn();
 
             ImGui::PopID();
@@ -460,14 +516,22 @@ void updateProcessDraw(GLFWwindow* window, Camera* camera, float timeStep) {
     }
     ImGui::SameLine(); ImGui::Text(l10nc("Add plane"));
 
+    try {
+        SceneData::lppshow->pollSolution();
+    } catch (std::runtime_error &dd_error) {
+        std::cerr << "Failed to solve equation: " << dd_error.what() << std::endl;
+    }
+
+    const bool isSolving = SceneData::lppshow->isSolving();
+    ImGui::BeginDisabled(isSolving);
     if (ImGui::Button(l10nc("Solve"))) {
-        try {
-            SceneData::lppshow->solve();
-        } catch (std::runtime_error &dd_error) {
-            std::cerr << "Failed to solve equation: " << dd_error.what() << std::endl;
-        }
+        SceneData::lppshow->solveAsync();
     }
+    ImGui::EndDisabled();
     const auto *solution = SceneData::lppshow->getSolution();
+    if (isSolving) {
+        ImGui::SameLine(); ImGui::Text(l10nc("Solving..."));
+    }
     if (solution->isErrored) {
         ImGui::TextColored({0.918, 0.025, 0.163, 1.0}, l10nc("Failed to solve the equation: %s"), solution->errorString.c_str());
     } else if (solution->isSolved) {
@@ -477,6 +541,32 @@ void updateProcessDraw(GLFWwindow* window, Camera* camera, float timeStep) {
         ImGui::Text(l10nc("Solution status: %s"), solution->statusString.c_str());
     }
 
+    // Developer-facing, same as the profiler, so no l10n
+    if (ImGui::TreeNode("Solve stats")) {
+        const SolveStats& stats = solution->stats;
+        ImGui::Text("Rows: %u (%u redundant), vertices: %u, rays: %u", stats.rowCount, stats.redundantRowCount, stats.vertexCount, stats.rayCount);
+        ImGui::Text("Edges: %u, faces: %u%s", stats.edgeCount, stats.facetCount, stats.isPolyhedraCached ? ", cached" : "");
+        if (stats.hasTimings) {
+            ImGui::Text("Total: %.1f us", stats.getTotalMicroseconds());
+            for (int stage = 0; stage < SOLVE_STAGE_COUNT; stage++) {
+                // Most solves skip most stages
+                if (stats.stageMicroseconds[stage] == 0) continue;
+                ImGui::BulletText("%s: %.1f us", SolveStats::getStageName(static_cast<SolveStage>(stage)), stats.stageMicroseconds[stage]);
+            }
+        } else if (!stats.isSolutionCached) {
+            ImGui::TextDisabled("Timings need a USE_SOLVE_STATS build");
+        }
+        if (stats.isSolutionCached) ImGui::Text("Straight from the solution cache");
+        SolutionCacheStats cache = SceneData::lppshow->getSolutionCacheStats();
+        ImGui::Text("Solution cache: %llu hits, %llu misses, %zu entries, %.1f of %.1f KiB",
+            static_cast<unsigned long long>(cache.hits), static_cast<unsigned long long>(cache.misses),
+            cache.entryCount, cache.bytes / 1024.0, cache.capacityBytes / 1024.0);
+        ImGui::TreePop();
+    }
+
+    ImGui::Checkbox("Show frame profiler", &SceneData::showProfiler);
+    if (SceneData::showProfiler) SceneData::profiler->draw(&SceneData::showProfiler);
+
     #ifdef DEBUG
     ImGui::Checkbox("Show debug overlay (imgui)", &SceneData::showDebugOverlay);
     ImGui::Checkbox("Toggle freecam", &SceneData::canMoveCamera);
@@ -485,19 +575,26 @@ void updateProcessDraw(GLFWwindow* window, Camera* camera, float timeStep) {
     #endif
 
     ImGui::End();
+    SceneData::profiler->end(PROFILE_IMGUI_BUILD);
 
     auto iio = ImGui::GetIO();
     if (SceneData::canMoveCamera && !(iio.WantCaptureKeyboard || iio.WantCaptureMouse))
         moveCamera(camera, window, timeStep);
 
-    SceneData::worldOrigin->render(camera->getView(), camera->getProjection());
-    SceneData::lppshow->render(camera);
+    // Every shader reads the camera from here, so that's the one upload it costs per frame
+    SceneData::cameraBuffer->update(CameraBlock { camera->getProjection(), camera->getView() });
+    SceneData::worldOrigin->render();
+    SceneData::lppshow->render();
 
+    {
+    ProfileScope imguiScope(SceneData::profiler, PROFILE_IMGUI_RENDER);
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
 }
 
 void glfwWindowResizeCallback(GLFWwindow *window, int width, int height) {
+    SceneData::hasPendingInput = true;
     imguiWindowSize.x = width * 0.25;
     imguiWindowSize.y = height;
 
@@ -528,6 +625,31 @@ void glfwMouseCallback(GLFWwindow* window) {
     glfwMouseCallback(window, positionX, positionY);
 }
 
+/**
+ * Anything the user does to the window means a redraw is due.
+ * Has to go in before ImGui's callbacks, those call ours after they're done.
+ */
+void installWakeCallbacks(GLFWwindow* window) {
+    glfwSetCursorPosCallback(window, [](GLFWwindow*, double, double) { SceneData::hasPendingInput = true; });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow*, int, int, int) { SceneData::hasPendingInput = true; });
+    glfwSetScrollCallback(window, [](GLFWwindow*, double, double) { SceneData::hasPendingInput = true; });
+    glfwSetKeyCallback(window, [](GLFWwindow*, int, int, int, int) { SceneData::hasPendingInput = true; });
+    glfwSetCharCallback(window, [](GLFWwindow*, unsigned int) { SceneData::hasPendingInput = true; });
+    glfwSetCursorEnterCallback(window, [](GLFWwindow*, int) { SceneData::hasPendingInput = true; });
+    glfwSetWindowFocusCallback(window, [](GLFWwindow*, int) { SceneData::hasPendingInput = true; });
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow*) { SceneData::hasPendingInput = true; });
+}
+
+// Held keys and buttons don't repeat their events every frame, but the camera still moves
+bool isInputHeld(GLFWwindow* window) {
+    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) || glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT)
+     || glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_MIDDLE)) return true;
+    for (int key : cameraKeys) {
+        if (glfwGetKey(window, key) == GLFW_PRESS) return true;
+    }
+    return false;
+}
+
 int main() {
     // XXX: Make GLFW init thing into an object?
     // That way we could use auto-destructors without worrying about
@@ -571,6 +693,7 @@ int main() {
     ////////////
     //// INIT IMGUI
     ////////////
+    installWakeCallbacks(mainWindow);
     ImGui::CreateContext();
     ImGui::StyleColorsDark();
     SettingsWindow::currentTheme = 0; // XXX: Must be synched with the call above
@@ -584,16 +707,16 @@ int main() {
     LocalMan::updateLocales();
     LocalMan::setToDefault();
     auto* camera = new Camera(windowWidth - imguiWindowSize.x, windowHeight);
-    camera->teleportTo(7.35889, 6.92579, 4.95831);
-    camera->rotate(-26.4407, 0.0, -133.3081);
-    // 7.35889 m, -6.92579 m, 4.95831 m // X, -Y, Z
-    // 63.5593°, 0°, 46.6919° // pitch - 90, 0, yaw - 180
-    camera->lookDepth = glm::length(camera->getCameraLocation());
+    camera->snapTo(VIEW_DEFAULT);
     SceneData::sceneCamera = camera;
 
     try {
         SceneData::lppshow = new Display();
         SceneData::worldOrigin = new WorldGridDisplay();
+        SceneData::cameraBuffer = new UniformBuffer(sizeof(CameraBlock), UNIFORM_BLOCK_CAMERA);
+        SceneData::profiler = new FrameProfiler();
+        SceneData::lppshow->profiler = SceneData::profiler;
+        SceneData::worldOrigin->profiler = SceneData::profiler;
     } catch (std::exception &ioerr) {
         // Might get to segfault
         return logCriticalError("Failed to compile required shaders");
@@ -601,9 +724,9 @@ int main() {
 
     // Setup LPP Display with usual x, y, z >= 0 constraints and turn them off
     SceneData::lppshow->objectiveFunction = {0, 0, 0, 0};
-    SceneData::lppshow->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN); SceneData::lppshow->visibleEquations[0] = false;
-    SceneData::lppshow->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN); SceneData::lppshow->visibleEquations[1] = false;
-    SceneData::lppshow->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN); SceneData::lppshow->visibleEquations[2] = false;
+    SceneData::lppshow->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN); SceneData::lppshow->setPlaneVisible(0, false);
+    SceneData::lppshow->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN); SceneData::lppshow->setPlaneVisible(1, false);
+    SceneData::lppshow->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN); SceneData::lppshow->setPlaneVisible(2, false);
     ImGuiIO& iio = ImGui::GetIO(); (void) iio;
     ImVector<ImWchar> ranges;
     ImFontGlyphRangesBuilder builder;
@@ -622,8 +745,27 @@ int main() {
     glfwWindowResizeCallback(mainWindow, windowWidth, windowHeight);
 
     float lastFrame, deltaTime = 0;
+    int framesToRender = FRAMES_AFTER_CHANGE;
+    unsigned long lastRevision = 0;
 
     while (!glfwWindowShouldClose(mainWindow)) {
+        if (SceneData::renderOnDemand && framesToRender <= 0 && !SceneData::hasPendingInput && !isInputHeld(mainWindow)) {
+            const bool isWorking = SceneData::lppshow->isSolving() || SceneData::pendingClasses.valid();
+            glfwWaitEventsTimeout(isWorking ? SOLVING_WAKE_INTERVAL : IDLE_WAKE_INTERVAL);
+            // Time spent asleep isn't a time step, and the cursor wandering around meanwhile isn't a drag
+            lastFrame = glfwGetTime();
+            glfwMouseCallback(mainWindow);
+            if (!SceneData::hasPendingInput && !isWorking) continue;
+        }
+        if (SceneData::hasPendingInput) {
+            SceneData::hasPendingInput = false;
+            framesToRender = FRAMES_AFTER_CHANGE;
+        }
+
+        // Awake and drawing from here on, so that's where the profiler's frame starts
+        SceneData::profiler->isEnabled = SceneData::showProfiler;
+        SceneData::profiler->newFrame();
+
         float time = glfwGetTime();
         deltaTime = time - lastFrame;
         lastFrame = time;
@@ -639,6 +781,15 @@ int main() {
         updateProcessDraw(mainWindow, camera, deltaTime);
 
         glfwSwapBuffers(mainWindow);
+        SceneData::profiler->endFrame();
+
+        // Camera moved, planes got edited or a solution came in: keep going for a bit
+        unsigned long revision = camera->getRevision() + SceneData::lppshow->getRevision();
+        if (revision != lastRevision) {
+            lastRevision = revision;
+            framesToRender = FRAMES_AFTER_CHANGE;
+        }
+        framesToRender--;
         glfwPollEvents();
     }
 
@@ -646,5 +797,7 @@ int main() {
     // As otherwise we attempt to asl now unloaded GL context to deallocate the object and shader buffers
     delete SceneData::lppshow;
     delete SceneData::worldOrigin;
+    delete SceneData::cameraBuffer;
+    delete SceneData::profiler;
     glfwTerminate();
 }
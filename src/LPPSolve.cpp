@@ -0,0 +1,564 @@
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "solver.h"
+#include "problem.h"
+#include "config.h"
+
+/**
+ * lppsolve: LPPShow without any of the showing. Reads problems in the problem.h format off
+ * stdin or files, solves them on a fixed pool of threads and writes one result per problem,
+ * in the same order they came in. Meant for sweeps over lots of small problems.
+ *
+ * The reader only splits the input on "---" lines, parsing is left to the workers along with
+ * the solve and the formatting. Problems go out in chunks, so the locks aren't hit per problem.
+ * Only so many chunks are let in flight, so memory stays flat no matter how long the input is.
+ */
+
+enum OutputFormat {
+    FORMAT_JSON = 0, // JSON lines, one object per problem
+    FORMAT_CSV = 1
+};
+
+namespace Options {
+    int threadCount = 0; // 0 is one per core
+    int chunkSize = 64;
+    OutputFormat format = FORMAT_JSON;
+    bool withVertices = false;
+    bool withStats = false;
+    SolverEngine engine = SolverEngine::ENGINE_SEIDEL;
+    EnumerationEngine enumeration = EnumerationEngine::ENUMERATION_DUAL_HULL;
+    std::string outputFile;
+    std::vector<std::string> problemFiles;
+}
+
+// One problem's worth of text, with where it started for the error messages
+struct ProblemText {
+    std::string source;
+    int firstLine;
+    std::string text;
+};
+
+struct Chunk {
+    size_t index;
+    size_t firstProblem;
+    std::vector<ProblemText> problems;
+};
+
+struct ChunkResult {
+    std::string output;
+    int failedCount = 0;
+};
+
+// Status names for people, not cddlib
+const char* statusName(const std::string& statusString) {
+    if (statusString == "dd_Optimal") return "optimal";
+    if (statusString == "dd_Inconsistent" || statusString == "dd_StrucInconsistent") return "infeasible";
+    if (statusString == "dd_DualInconsistent" || statusString == "dd_StrucDualInconsistent") return "unbounded";
+    return nullptr;
+}
+
+// snprintf instead of ostreams, those are way too slow for a million lines
+void appendNumber(std::string& output, double number) {
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%.9g", number);
+    output.append(buffer, length);
+}
+
+void appendNumber(std::string& output, size_t number) {
+    char buffer[24];
+    int length = std::snprintf(buffer, sizeof(buffer), "%zu", number);
+    output.append(buffer, length);
+}
+
+void appendJSONString(std::string& output, const std::string& text) {
+    output += '"';
+    for (char character : text) {
+        switch (character) {
+            case '"': output += "\\\""; break;
+            case '\\': output += "\\\\"; break;
+            case '\n': output += "\\n"; break;
+            case '\t': output += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(character) < 0x20) {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", character);
+                    output += buffer;
+                } else output += character;
+        }
+    }
+    output += '"';
+}
+
+// Doubles quotes, same as every spreadsheet out there expects
+void appendCSVString(std::string& output, const std::string& text) {
+    output += '"';
+    for (char character : text) {
+        if (character == '"') output += '"';
+        output += character;
+    }
+    output += '"';
+}
+
+void writeCSVHeader(std::ostream& output) {
+    output << "index,status,value,x,y,z";
+    if (Options::withVertices) output << ",vertices,adjacency";
+    if (Options::withStats) {
+        output << ",rows,redundant_rows,vertex_count,ray_count,edge_count,facet_count,cached,total_us";
+        for (int stage = 0; stage < SOLVE_STAGE_COUNT; stage++) output << "," << SolveStats::getStageName(static_cast<SolveStage>(stage)) << "_us";
+    }
+    output << ",error\n";
+}
+
+/**
+ * JSON gets {"rows":..,..,"stages":{"seidel":..}} with only the stages that ran,
+ * CSV a fixed set of columns, empty where there's nothing to say.
+ * Timings are left out entirely on builds without USE_SOLVE_STATS.
+ */
+void appendStats(std::string& output, const SolveStats* stats) {
+    if (Options::format == FORMAT_JSON) {
+        if (stats == nullptr) return;
+        output += ",\"stats\":{\"rows\":";
+        appendNumber(output, static_cast<size_t>(stats->rowCount));
+        output += ",\"redundant_rows\":";
+        appendNumber(output, static_cast<size_t>(stats->redundantRowCount));
+        output += ",\"vertices\":";
+        appendNumber(output, static_cast<size_t>(stats->vertexCount));
+        output += ",\"rays\":";
+        appendNumber(output, static_cast<size_t>(stats->rayCount));
+        output += ",\"edges\":";
+        appendNumber(output, static_cast<size_t>(stats->edgeCount));
+        output += ",\"facets\":";
+        appendNumber(output, static_cast<size_t>(stats->facetCount));
+        output += stats->isPolyhedraCached ? ",\"cached\":true" : ",\"cached\":false";
+        if (stats->hasTimings) {
+            output += ",\"total_us\":";
+            appendNumber(output, stats->getTotalMicroseconds());
+            output += ",\"stages\":{";
+            bool isFirst = true;
+            for (int stage = 0; stage < SOLVE_STAGE_COUNT; stage++) {
+                if (stats->stageMicroseconds[stage] == 0) continue;
+                if (!isFirst) output += ',';
+                isFirst = false;
+                appendJSONString(output, SolveStats::getStageName(static_cast<SolveStage>(stage)));
+                output += ':';
+                appendNumber(output, stats->stageMicroseconds[stage]);
+            }
+            output += '}';
+        }
+        output += '}';
+    } else {
+        if (stats == nullptr) {
+            output.append(8 + SOLVE_STAGE_COUNT, ',');
+            return;
+        }
+        for (uint32_t count : { stats->rowCount, stats->redundantRowCount, stats->vertexCount, stats->rayCount, stats->edgeCount, stats->facetCount }) {
+            output += ',';
+            appendNumber(output, static_cast<size_t>(count));
+        }
+        output += stats->isPolyhedraCached ? ",1," : ",0,";
+        if (stats->hasTimings) appendNumber(output, stats->getTotalMicroseconds());
+        for (int stage = 0; stage < SOLVE_STAGE_COUNT; stage++) {
+            output += ',';
+            if (stats->hasTimings) appendNumber(output, stats->stageMicroseconds[stage]);
+        }
+    }
+}
+
+/**
+ * One line per problem. JSON:
+ *   {"index":0,"status":"optimal","value":1,"vector":[1,0,0],"vertices":[[..]],"adjacency":[[..]]}
+ * CSV, with vertices as "x y z|x y z|.." and adjacency as "1 2|0 2|..":
+ *   index,status,value,x,y,z,vertices,adjacency,error
+ * Adjacency is counted from 0, same as the solver's. Failed problems get status "error" and the message.
+ * --stats goes in right before the error, see appendStats().
+ */
+void appendResult(std::string& output, size_t index, LinearProgrammingProblem* problem, const std::string& error) {
+    const char* status = "error";
+    std::string otherStatus; // Whatever cddlib said that doesn't have a better name
+    auto solution = problem != nullptr ? problem->getSolution() : nullptr;
+    if (solution != nullptr && error.empty()) {
+        status = statusName(solution->statusString);
+        if (status == nullptr) {
+            otherStatus = solution->statusString;
+            status = otherStatus.c_str();
+        }
+    }
+    bool hasOptimum = error.empty() && solution != nullptr && solution->isSolved;
+    bool hasRegion = Options::withVertices && error.empty() && solution != nullptr;
+    const SolveStats* stats = error.empty() && solution != nullptr ? &solution->stats : nullptr;
+
+    if (Options::format == FORMAT_JSON) {
+        output += "{\"index\":";
+        appendNumber(output, index);
+        output += ",\"status\":";
+        appendJSONString(output, status);
+        if (hasOptimum) {
+            output += ",\"value\":";
+            appendNumber(output, solution->optimalValue);
+            output += ",\"vector\":[";
+            for (int axis = 0; axis < 3; axis++) {
+                if (axis != 0) output += ',';
+                appendNumber(output, solution->optimalVector[axis]);
+            }
+            output += ']';
+        }
+        if (hasRegion) {
+            output += ",\"vertices\":[";
+            const auto& vertices = solution->polyhedraVertices;
+            for (size_t vertex = 0; vertex + 2 < vertices.size(); vertex += 3) {
+                if (vertex != 0) output += ',';
+                output += '[';
+                appendNumber(output, vertices[vertex]); output += ',';
+                appendNumber(output, vertices[vertex + 1]); output += ',';
+                appendNumber(output, vertices[vertex + 2]);
+                output += ']';
+            }
+            output += "],\"adjacency\":[";
+            const Adjacency& adjacency = solution->adjacency;
+            for (size_t vertex = 0; vertex < adjacency.getVertexCount(); vertex++) {
+                if (vertex != 0) output += ',';
+                output += '[';
+                for (uint32_t neighbour = adjacency.offsets[vertex]; neighbour < adjacency.offsets[vertex + 1]; neighbour++) {
+                    if (neighbour != adjacency.offsets[vertex]) output += ',';
+                    appendNumber(output, static_cast<size_t>(adjacency.neighbours[neighbour]));
+                }
+                output += ']';
+            }
+            output += ']';
+        }
+        if (Options::withStats) appendStats(output, stats);
+        if (!error.empty()) {
+            output += ",\"error\":";
+            appendJSONString(output, error);
+        }
+        output += "}\n";
+    } else {
+        appendNumber(output, index);
+        output += ',';
+        output += status;
+        output += ',';
+        if (hasOptimum) {
+            appendNumber(output, solution->optimalValue);
+            for (int axis = 0; axis < 3; axis++) {
+                output += ',';
+                appendNumber(output, solution->optimalVector[axis]);
+            }
+        } else output += ",,,";
+        if (Options::withVertices) {
+            output += ',';
+            if (hasRegion) {
+                const auto& vertices = solution->polyhedraVertices;
+                for (size_t vertex = 0; vertex + 2 < vertices.size(); vertex += 3) {
+                    if (vertex != 0) output += '|';
+                    appendNumber(output, vertices[vertex]); output += ' ';
+                    appendNumber(output, vertices[vertex + 1]); output += ' ';
+                    appendNumber(output, vertices[vertex + 2]);
+                }
+            }
+            output += ',';
+            if (hasRegion) {
+                const Adjacency& adjacency = solution->adjacency;
+                for (size_t vertex = 0; vertex < adjacency.getVertexCount(); vertex++) {
+                    if (vertex != 0) output += '|';
+                    for (uint32_t neighbour = adjacency.offsets[vertex]; neighbour < adjacency.offsets[vertex + 1]; neighbour++) {
+                        if (neighbour != adjacency.offsets[vertex]) output += ' ';
+                        appendNumber(output, static_cast<size_t>(adjacency.neighbours[neighbour]));
+                    }
+                }
+            }
+        }
+        if (Options::withStats) appendStats(output, stats);
+        output += ',';
+        if (!error.empty()) appendCSVString(output, error);
+        output += '\n';
+    }
+}
+
+/**
+ * Fixed set of workers, each with its own LinearProgrammingProblem to parse into and solve.
+ * Results are picked up by whoever calls submit()/finish(), strictly in chunk order.
+ */
+class SolvePool {
+    private:
+    std::mutex poolLock;
+    std::condition_variable jobsChanged;
+    std::condition_variable resultsChanged;
+    std::deque<Chunk> jobs;
+    std::map<size_t, ChunkResult> results; // Done, but something before them isn't yet
+    size_t nextChunk = 0;
+    size_t nextToWrite = 0;
+    size_t inFlight = 0;
+    size_t maxInFlight;
+    bool isFinishing = false;
+    std::ostream& output;
+    std::vector<std::thread> workers;
+
+    void run() {
+        LinearProgrammingProblem problem;
+        problem.engine = Options::engine;
+        problem.setSolutionCacheCapacity(0); // Problems don't come back around, the key and the insert would be all it does
+        problem.enumeration = Options::withVertices ? Options::enumeration : EnumerationEngine::ENUMERATION_NONE;
+        while (true) {
+            Chunk chunk;
+            {
+                std::unique_lock<std::mutex> lock(poolLock);
+                jobsChanged.wait(lock, [this]() { return isFinishing || !jobs.empty(); });
+                if (jobs.empty()) return;
+                chunk = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            ChunkResult result;
+            for (size_t offset = 0; offset < chunk.problems.size(); offset++) {
+                const ProblemText& text = chunk.problems[offset];
+                std::string error;
+                try {
+                    std::istringstream input(text.text);
+                    int lineNumber = text.firstLine;
+                    readProblem(input, problem, lineNumber);
+                    problem.solve();
+                } catch (std::runtime_error &solveError) {
+                    error = text.source + ": " + solveError.what();
+                    result.failedCount++;
+                }
+                appendResult(result.output, chunk.firstProblem + offset, &problem, error);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(poolLock);
+                results.emplace(chunk.index, std::move(result));
+            }
+            resultsChanged.notify_one();
+        }
+    }
+
+    // Writes out everything that's ready in order. Lock held on the way in and out, not while writing
+    void writeReady(std::unique_lock<std::mutex>& lock) {
+        auto ready = results.find(nextToWrite);
+        while (ready != results.end()) {
+            ChunkResult result = std::move(ready->second);
+            results.erase(ready);
+            lock.unlock();
+            output.write(result.output.data(), result.output.size());
+            failedCount += result.failedCount;
+            lock.lock();
+            nextToWrite++;
+            inFlight--;
+            ready = results.find(nextToWrite);
+        }
+    }
+
+    public:
+    int failedCount = 0; // Only to be read after finish()
+
+    SolvePool(int threadCount, std::ostream& output): output(output) {
+        maxInFlight = static_cast<size_t>(threadCount) * 4;
+        for (int thread = 0; thread < threadCount; thread++) workers.emplace_back(&SolvePool::run, this);
+    }
+
+    // Blocks while there's too much in flight, writing results out in the meantime
+    void submit(std::vector<ProblemText>&& problems, size_t firstProblem) {
+        std::unique_lock<std::mutex> lock(poolLock);
+        while (inFlight >= maxInFlight) {
+            resultsChanged.wait(lock, [this]() { return results.count(nextToWrite) != 0; });
+            writeReady(lock);
+        }
+        jobs.push_back(Chunk { nextChunk++, firstProblem, std::move(problems) });
+        inFlight++;
+        jobsChanged.notify_one();
+        writeReady(lock);
+    }
+
+    // Waits for the rest and writes it out
+    void finish() {
+        std::unique_lock<std::mutex> lock(poolLock);
+        isFinishing = true;
+        jobsChanged.notify_all();
+        while (inFlight > 0) {
+            resultsChanged.wait(lock, [this]() { return results.count(nextToWrite) != 0; });
+            writeReady(lock);
+        }
+        lock.unlock();
+        for (std::thread& worker : workers) if (worker.joinable()) worker.join();
+        output.flush();
+    }
+
+    ~SolvePool() {
+        {
+            std::lock_guard<std::mutex> lock(poolLock);
+            isFinishing = true;
+        }
+        jobsChanged.notify_all();
+        for (std::thread& worker : workers) if (worker.joinable()) worker.join();
+    }
+};
+
+/**
+ * Cuts the stream into problems along "---" lines and feeds them to the pool in chunks.
+ * Blank and comment-only stretches don't count as problems, same as readProblem() does it.
+ * Returns how many problems there were, so the next file carries on counting from there.
+ */
+size_t feedProblems(std::istream& input, const std::string& source, SolvePool& pool, size_t firstProblem) {
+    std::vector<ProblemText> chunk;
+    chunk.reserve(Options::chunkSize);
+    size_t problemIndex = firstProblem;
+    ProblemText current { source, 0, "" };
+    bool hasAnything = false;
+    int lineNumber = 0;
+
+    auto endProblem = [&]() {
+        if (hasAnything) {
+            chunk.push_back(std::move(current));
+            problemIndex++;
+            if (chunk.size() >= static_cast<size_t>(Options::chunkSize)) {
+                size_t chunkStart = problemIndex - chunk.size();
+                pool.submit(std::move(chunk), chunkStart);
+                chunk = std::vector<ProblemText>();
+                chunk.reserve(Options::chunkSize);
+            }
+        }
+        current = ProblemText { source, lineNumber, "" };
+        hasAnything = false;
+    };
+
+    std::string line;
+    while (std::getline(input, line)) {
+        lineNumber++;
+        size_t start = line.find_first_not_of(" \t\r");
+        bool isBlank = start == std::string::npos || line[start] == '#';
+        if (!isBlank && line.compare(start, 3, "---") == 0) {
+            size_t end = line.find_first_not_of(" \t\r", start + 3);
+            if (end == std::string::npos || line[end] == '#') {
+                endProblem();
+                continue;
+            }
+        }
+        // Lines before the first real one are skipped, readProblem() starts counting from firstLine
+        if (!hasAnything && isBlank) {
+            current.firstLine = lineNumber;
+            continue;
+        }
+        hasAnything = true;
+        current.text += line;
+        current.text += '\n';
+    }
+    endProblem();
+    if (!chunk.empty()) {
+        size_t chunkStart = problemIndex - chunk.size();
+        pool.submit(std::move(chunk), chunkStart);
+    }
+    return problemIndex - firstProblem;
+}
+
+void printUsage(const char* executable) {
+    std::cerr << "Usage: " << executable << " [options] [problem files...]\n"
+              << "  --threads N         worker count, one per core by default\n"
+              << "  --format NAME       json (JSON lines, default) or csv\n"
+              << "  --vertices          also write out the region's vertices and adjacency\n"
+              << "  --engine NAME       seidel (default) or cddlib\n"
+              << "  --enumeration NAME  hull (default) or dd, only matters with --vertices\n"
+              << "  --stats             also write out counts and per-stage timings of each solve\n"
+              << "  --output FILE       write there instead of stdout\n"
+              << "Reads stdin if there are no files, or for \"-\". Results come out in input order,\n"
+              << "numbered from 0 across all the files." << std::endl;
+}
+
+bool parseArguments(int argc, char** argv) {
+    for (int argument = 1; argument < argc; argument++) {
+        std::string option = argv[argument];
+        bool hasValue = argument + 1 < argc;
+        if (option == "--threads" && hasValue) {
+            Options::threadCount = std::atoi(argv[++argument]);
+            if (Options::threadCount <= 0) return false;
+        } else if (option == "--format" && hasValue) {
+            std::string format = argv[++argument];
+            if (format == "json") Options::format = FORMAT_JSON;
+            else if (format == "csv") Options::format = FORMAT_CSV;
+            else return false;
+        } else if (option == "--vertices") {
+            Options::withVertices = true;
+        } else if (option == "--stats") {
+            Options::withStats = true;
+        } else if (option == "--engine" && hasValue) {
+            std::string engine = argv[++argument];
+            if (engine == "cddlib") Options::engine = SolverEngine::ENGINE_CDDLIB;
+            else if (engine == "seidel") Options::engine = SolverEngine::ENGINE_SEIDEL;
+            else return false;
+        } else if (option == "--enumeration" && hasValue) {
+            std::string enumeration = argv[++argument];
+            if (enumeration == "dd") Options::enumeration = EnumerationEngine::ENUMERATION_DOUBLE_DESCRIPTION;
+            else if (enumeration == "hull") Options::enumeration = EnumerationEngine::ENUMERATION_DUAL_HULL;
+            else return false;
+        } else if (option == "--output" && hasValue) {
+            Options::outputFile = argv[++argument];
+        } else if (option == "-") {
+            Options::problemFiles.push_back(option);
+        } else if (option.size() > 1 && option[0] == '-') {
+            return false;
+        } else {
+            Options::problemFiles.push_back(option);
+        }
+    }
+    if (Options::problemFiles.empty()) Options::problemFiles.push_back("-");
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (!parseArguments(argc, argv)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (Options::threadCount == 0) {
+        Options::threadCount = std::thread::hardware_concurrency();
+        if (Options::threadCount == 0) Options::threadCount = 1; // Allowed to not know, apparently
+    }
+
+    std::ios::sync_with_stdio(false);
+    std::ofstream outputFile;
+    if (!Options::outputFile.empty()) {
+        outputFile.open(Options::outputFile);
+        if (!outputFile) {
+            std::cerr << Options::outputFile << ": can't open for writing" << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& output = Options::outputFile.empty() ? std::cout : outputFile;
+    if (Options::format == FORMAT_CSV) writeCSVHeader(output);
+
+    int failedCount = 0;
+    size_t problemCount = 0;
+    {
+        SolvePool pool(Options::threadCount, output);
+        for (const std::string& problemFile : Options::problemFiles) {
+            if (problemFile == "-") {
+                problemCount += feedProblems(std::cin, "stdin", pool, problemCount);
+                continue;
+            }
+            std::ifstream input(problemFile);
+            if (!input) {
+                std::cerr << problemFile << ": can't open" << std::endl;
+                failedCount++;
+                continue;
+            }
+            problemCount += feedProblems(input, problemFile, pool, problemCount);
+        }
+        pool.finish();
+        failedCount += pool.failedCount;
+    }
+
+    std::cerr << problemCount << " problems, " << failedCount << " failed" << std::endl;
+    return failedCount == 0 ? 0 : 2;
+}
@@ -1,5 +1,7 @@
 #include "assets.h"
 #include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -50,6 +52,8 @@ Object::Object() {
     this->objectData = 0;
     this->vertexData = 0;
     this->indices = 0;
+    this->instanceData = 0;
+    this->instanceCapacity = 0;
 }
 
 void Object::genArrays() {
@@ -106,6 +110,42 @@ void Object::setVertexData(
     }
 }
 
+void Object::setInstanceData(const InstanceAttributePlane* instances, size_t count, size_t capacity) {
+    this->genArrays();
+    if (this->instanceData == 0) glGenBuffers(1, &this->instanceData);
+    glBindVertexArray(this->objectData);
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceData);
+    // Orphan and refill, the driver can keep drawing from the old one meanwhile
+    glBufferData(GL_ARRAY_BUFFER, sizeof(*instances) * capacity, nullptr, GL_DYNAMIC_DRAW);
+    if (count > 0) glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(*instances) * count, instances);
+
+    // mat4 doesn't fit into one attribute, so it's four vec4 columns in a row
+    for (int column = 0; column < 4; column++) {
+        glVertexAttribPointer(1 + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceAttributePlane),
+            (void*) (offsetof(InstanceAttributePlane, transform) + sizeof(glm::vec4) * column));
+        glEnableVertexAttribArray(1 + column);
+        glVertexAttribDivisor(1 + column, 1);
+    }
+    glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceAttributePlane), (void*) offsetof(InstanceAttributePlane, positiveColor));
+    glEnableVertexAttribArray(5);
+    glVertexAttribDivisor(5, 1);
+    glVertexAttribPointer(6, 1, GL_FLOAT, GL_FALSE, sizeof(InstanceAttributePlane), (void*) offsetof(InstanceAttributePlane, isVisible));
+    glEnableVertexAttribArray(6);
+    glVertexAttribDivisor(6, 1);
+
+    this->instanceCapacity = capacity;
+}
+
+void Object::updateInstanceData(const InstanceAttributePlane* instances, size_t offset, size_t count) {
+    if (offset + count > this->instanceCapacity)
+        throw std::runtime_error("Instance data doesn't fit into the buffer");
+    if (count == 0) return;
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceData);
+    glBufferSubData(GL_ARRAY_BUFFER, sizeof(*instances) * offset, sizeof(*instances) * count, instances);
+}
+
+size_t Object::getInstanceCapacity() const { return this->instanceCapacity; }
+
 void Object::bindForDraw(GLenum mode) const {
     if (this->objectData == 0 || this->vertexData == 0 || this->indices == 0)
         return;
@@ -135,8 +175,28 @@ Object::~Object() {
     if (this->vertexData != 0) glDeleteBuffers(1, &this->vertexData);
     if (this->objectData != 0) glDeleteBuffers(1, &this->objectData);
     if (this->indices != 0) glDeleteBuffers(1, &this->indices);
+    if (this->instanceData != 0) glDeleteBuffers(1, &this->instanceData);
 }
 
+// UNIFORM BUFFERS
+
+UniformBuffer::UniformBuffer(size_t size, UniformBlockBinding binding) {
+    this->bufferSize = size;
+    glGenBuffers(1, &this->bufferData);
+    glBindBuffer(GL_UNIFORM_BUFFER, this->bufferData);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, this->bufferData);
+}
+
+void UniformBuffer::update(const void* data, size_t size, size_t offset) {
+    if (offset + size > this->bufferSize)
+        throw std::runtime_error("Uniform data doesn't fit into the buffer");
+    glBindBuffer(GL_UNIFORM_BUFFER, this->bufferData);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+}
+
+UniformBuffer::~UniformBuffer() { if (this->bufferData != 0) glDeleteBuffers(1, &this->bufferData); }
+
 // SHADERS
 
 std::string readFileDry(const char* filename) noexcept(false) {
@@ -159,6 +219,7 @@ std::string readFileDry(const char* filename) noexcept(false) {
 };
 
 std::unique_ptr<char> Shader::sCompileLog = std::make_unique<char>(512);
+bool Shader::isLookingUpEveryCall = false;
 
 GLuint Shader::compileShader(const char* shaderSource, GLenum shaderType) noexcept(false) {
     GLuint shaderPtr = glCreateShader(shaderType);
@@ -207,10 +268,12 @@ Shader::Shader(char const* vertexShaderPath, char const* fragmentShaderPath) {
     GLuint vertexShader = Shader::compileShader(vertexShaderText.c_str(), GL_VERTEX_SHADER);
     GLuint fragmentShader = Shader::compileShader(fragmentShaderText.c_str(), GL_FRAGMENT_SHADER);
     this->pShaderProgram = Shader::linkProgram(vertexShader, fragmentShader);
+    this->reflectUniforms();
 }
 
 Shader::Shader(GLuint programId) {
     this->pShaderProgram = programId;
+    this->reflectUniforms();
 }
 
 Shader* Shader::fromSource(const char* vertexSource, const char* fragmentSource) {
@@ -221,47 +284,74 @@ Shader* Shader::fromSource(const char* vertexSource, const char* fragmentSource)
     return new Shader(shaderProgram);
 }
 
-Shader::~Shader() { if (this->pShaderProgram != 0) glDeleteProgram(this->pShaderProgram); }
-
-void Shader::activate() const { glUseProgram(this->pShaderProgram); }
-
-void Shader::setTransform(glm::mat4 projection, glm::mat4 view) const {
-    glUniformMatrix4fv(glGetUniformLocation(this->pShaderProgram, "projection"), 1, GL_FALSE, &projection[0][0]);
-    glUniformMatrix4fv(glGetUniformLocation(this->pShaderProgram, "view"), 1, GL_FALSE, &view[0][0]);
-}
-
-void Shader::setUniform(const char *name, int uniformValue) const {
-    glUniform1i(glGetUniformLocation(this->pShaderProgram, name), uniformValue);
-}
-
-void Shader::setUniform(const char*name, float uniformValue) const {
-    glUniform1f(glGetUniformLocation(this->pShaderProgram, name), uniformValue);
-}
-
-void Shader::setUniform(const char*name, double uniformValue) const {
-    glUniform1f(glGetUniformLocation(this->pShaderProgram, name), uniformValue);
-}
+// Uniforms can't change after linking, so one pass over the active ones covers everything we'll ever ask for
+void Shader::reflectUniforms() {
+    GLint uniformCount = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(this->pShaderProgram, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(this->pShaderProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::string uniformName(std::max(maxNameLength, 1), '\0');
+    this->uniformLocations.clear();
+    this->uniformLocations.reserve(uniformCount);
+    for (GLint uniformIndex = 0; uniformIndex < uniformCount; uniformIndex++) {
+        GLsizei nameLength = 0;
+        GLint arraySize = 0;
+        GLenum uniformType = 0;
+        glGetActiveUniform(this->pShaderProgram, uniformIndex, uniformName.size(), &nameLength, &arraySize, &uniformType, &uniformName[0]);
+        std::string name = uniformName.substr(0, nameLength);
+        GLint location = glGetUniformLocation(this->pShaderProgram, name.c_str());
+        if (location < 0) continue; // Lives in a uniform block, not ours to set
+        this->uniformLocations[name] = location;
+        // Arrays come back as "name[0]", but plain "name" means the same thing to GL,
+        // and the rest of the elements have to be asked for one by one
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+            std::string arrayName = name.substr(0, name.size() - 3);
+            this->uniformLocations[arrayName] = location;
+            for (GLint element = 1; element < arraySize; element++) {
+                std::string elementName = arrayName + "[" + std::to_string(element) + "]";
+                this->uniformLocations[elementName] = glGetUniformLocation(this->pShaderProgram, elementName.c_str());
+            }
+        }
+    }
 
-void Shader::setUniform(const char*name, glm::vec2 uniformValue) const {
-    glUniform2f(glGetUniformLocation(this->pShaderProgram, name), uniformValue.x, uniformValue.y);
+    this->bindUniformBlock("Camera", UNIFORM_BLOCK_CAMERA);
 }
 
-void Shader::setUniform(const char*name, glm::vec3 uniformValue) const {
-    glUniform3f(glGetUniformLocation(this->pShaderProgram, name), uniformValue.x, uniformValue.y, uniformValue.z);
+void Shader::bindUniformBlock(const char* blockName, UniformBlockBinding binding) {
+    GLuint blockIndex = glGetUniformBlockIndex(this->pShaderProgram, blockName);
+    if (blockIndex == GL_INVALID_INDEX) return; // Doesn't use it, fine by us
+    glUniformBlockBinding(this->pShaderProgram, blockIndex, binding);
 }
 
-void Shader::setUniform(const char*name, glm::vec4 uniformValue) const {
-    glUniform4f(glGetUniformLocation(this->pShaderProgram, name), uniformValue.x, uniformValue.y, uniformValue.z, uniformValue.w);
+int Shader::locate(const char* name) const {
+    if (Shader::isLookingUpEveryCall) return glGetUniformLocation(this->pShaderProgram, name);
+    auto uniform = this->uniformLocations.find(name);
+    // Optimized out or just misspelled, GL would've said -1 as well
+    if (uniform == this->uniformLocations.end()) return -1;
+    return uniform->second;
 }
 
-void Shader::setUniform(const char*name, glm::mat2 uniformValue) const {
-    glUniformMatrix2fv(glGetUniformLocation(this->pShaderProgram, name), 1, GL_FALSE, &uniformValue[0][0]);
-}
+Shader::~Shader() { if (this->pShaderProgram != 0) glDeleteProgram(this->pShaderProgram); }
 
-void Shader::setUniform(const char*name, glm::mat3 uniformValue) const {
-    glUniformMatrix3fv(glGetUniformLocation(this->pShaderProgram, name), 1, GL_FALSE, &uniformValue[0][0]);
-}
+void Shader::activate() const { glUseProgram(this->pShaderProgram); }
 
-void Shader::setUniform(const char*name, glm::mat4 uniformValue) const {
-    glUniformMatrix4fv(glGetUniformLocation(this->pShaderProgram, name), 1, GL_FALSE, &uniformValue[0][0]);
-}
+void Shader::upload(int location, int value) { glUniform1i(location, value); }
+void Shader::upload(int location, float value) { glUniform1f(location, value); }
+void Shader::upload(int location, double value) { glUniform1f(location, value); }
+void Shader::upload(int location, glm::vec2 value) { glUniform2f(location, value.x, value.y); }
+void Shader::upload(int location, glm::vec3 value) { glUniform3f(location, value.x, value.y, value.z); }
+void Shader::upload(int location, glm::vec4 value) { glUniform4f(location, value.x, value.y, value.z, value.w); }
+void Shader::upload(int location, const glm::mat2& value) { glUniformMatrix2fv(location, 1, GL_FALSE, &value[0][0]); }
+void Shader::upload(int location, const glm::mat3& value) { glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]); }
+void Shader::upload(int location, const glm::mat4& value) { glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]); }
+
+void Shader::setUniform(const char* name, int uniformValue) const { Shader::upload(this->locate(name), uniformValue); }
+void Shader::setUniform(const char* name, float uniformValue) const { Shader::upload(this->locate(name), uniformValue); }
+void Shader::setUniform(const char* name, double uniformValue) const { Shader::upload(this->locate(name), uniformValue); }
+void Shader::setUniform(const char* name, glm::vec2 uniformValue) const { Shader::upload(this->locate(name), uniformValue); }
+void Shader::setUniform(const char* name, glm::vec3 uniformValue) const { Shader::upload(this->locate(name), uniformValue); }
+void Shader::setUniform(const char* name, glm::vec4 uniformValue) const { Shader::upload(this->locate(name), uniformValue); }
+void Shader::setUniform(const char* name, glm::mat2 uniformValue) const { Shader::upload(this->locate(name), uniformValue); }
+void Shader::setUniform(const char* name, glm::mat3 uniformValue) const { Shader::upload(this->locate(name), uniformValue); }
+void Shader::setUniform(const char* name, glm::mat4 uniformValue) const { Shader::upload(this->locate(name), uniformValue); }
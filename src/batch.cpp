@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "solver.h"
+#include "seidel.h"
+#include "workpool.h"
+
+namespace {
+
+BatchStatus batchStatus(SeidelStatus status) {
+    switch (status) {
+        case SEIDEL_OPTIMAL: return BATCH_OPTIMAL;
+        case SEIDEL_INFEASIBLE: return BATCH_INFEASIBLE;
+        case SEIDEL_UNBOUNDED: return BATCH_UNBOUNDED;
+        default: return BATCH_ERROR; // Degenerate, cddlib gets to decide
+    }
+}
+
+// cddlib's side of it, which only comes back as a string by the time solveSnapshot() is done
+BatchStatus batchStatus(const std::string& statusString) {
+    if (statusString == "dd_Optimal") return BATCH_OPTIMAL;
+    if (statusString == "dd_Inconsistent" || statusString == "dd_StrucInconsistent") return BATCH_INFEASIBLE;
+    if (statusString == "dd_DualInconsistent" || statusString == "dd_StrucDualInconsistent") return BATCH_UNBOUNDED;
+    return BATCH_ERROR;
+}
+
+} // namespace
+
+void LinearProgrammingProblem::solveBatch(const BatchProblem* problems, size_t count, BatchResult* results, int threadCount, SolverEngine engine) {
+    if (count == 0) return;
+    if (threadCount <= 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    // Indices are 32 bit to fit two into a word. Four billion problems at once is someone else's problem
+    if (count > UINT32_MAX) {
+        for (size_t offset = 0; offset < count; offset += UINT32_MAX) {
+            size_t slice = std::min<size_t>(UINT32_MAX, count - offset);
+            solveBatch(problems + offset, slice, results + offset, threadCount, engine);
+        }
+        return;
+    }
+    threadCount = getWorkerCount(static_cast<uint32_t>(count), threadCount);
+    // Scratch for each thread, vectors keep their capacity from problem to problem.
+    // Seidel keeps its own rows per thread too, so a batch that stays on Seidel doesn't allocate past the first few
+    struct Scratch {
+        std::vector<glm::dvec4> halfspaces;
+        Snapshot snapshot; // Only for the ones that end up going through cddlib
+    };
+    std::vector<Scratch> scratch(threadCount, Scratch { {}, Snapshot { {}, glm::vec4(0), true, engine, EnumerationEngine::ENUMERATION_NONE, nullptr } });
+
+    forEachStealing(static_cast<uint32_t>(count), threadCount, [&](int worker, uint32_t index) {
+        std::vector<glm::dvec4>& halfspaces = scratch[worker].halfspaces;
+        const BatchProblem& problem = problems[index];
+        BatchResult& result = results[index];
+        result.status = BATCH_ERROR;
+
+        if (engine == SolverEngine::ENGINE_SEIDEL) {
+            // Same rows getHalfspaces() would make, zeroes skipped the way collectPointless() does
+            halfspaces.clear();
+            for (uint32_t plane = 0; plane < problem.planeCount; plane++) {
+                if (problem.planes[plane] == glm::vec4(0)) continue;
+                glm::dvec4 coeff = glm::dvec4(problem.planes[plane]);
+                switch (problem.types != nullptr ? problem.types[plane] : EquationType::LESS_EQUAL_THAN) {
+                    case EquationType::LESS_EQUAL_THAN: halfspaces.push_back(coeff); break;
+                    case EquationType::GREATER_EQUAL_THAN: halfspaces.push_back(-coeff); break;
+                    case EquationType::EQUAL_TO: halfspaces.push_back(coeff); halfspaces.push_back(-coeff); break;
+                }
+            }
+            glm::dvec3 objective = glm::dvec3(problem.objectiveFunction);
+            SeidelResult optimum = seidelMaximize(halfspaces, problem.doMinimize ? -objective : objective);
+            result.status = batchStatus(optimum.status);
+            if (result.status == BATCH_OPTIMAL) {
+                result.optimalVector = glm::vec3(optimum.point);
+                result.optimalValue = glm::dot(objective, optimum.point) + problem.objectiveFunction.w;
+            }
+        }
+        // Asked for cddlib, or Seidel wasn't sure: whole solveSnapshot() it is, under cddlib's lock anyway
+        if (result.status == BATCH_ERROR) {
+            Snapshot& snapshot = scratch[worker].snapshot;
+            snapshot.planeEquations.clear();
+            for (uint32_t plane = 0; plane < problem.planeCount; plane++) {
+                if (problem.planes[plane] == glm::vec4(0)) continue;
+                EquationType type = problem.types != nullptr ? problem.types[plane] : EquationType::LESS_EQUAL_THAN;
+                snapshot.planeEquations.push_back(Equation { problem.planes[plane], type });
+            }
+            snapshot.objectiveFunction = problem.objectiveFunction;
+            snapshot.doMinimize = problem.doMinimize;
+            snapshot.engine = SolverEngine::ENGINE_CDDLIB; // Seidel already had its go
+            try {
+                Solution solution = solveSnapshot(snapshot);
+                result.status = batchStatus(solution.statusString);
+                if (result.status == BATCH_OPTIMAL) {
+                    result.optimalValue = solution.optimalValue;
+                    result.optimalVector = solution.optimalVector;
+                }
+            } catch (std::runtime_error &error) {
+                result.status = BATCH_ERROR;
+            }
+        }
+        if (result.status != BATCH_OPTIMAL) {
+            result.optimalValue = 0;
+            result.optimalVector = glm::vec3(0);
+        }
+    });
+}
@@ -21,6 +21,7 @@ void Camera::applyRotation() {
     // Pitch:
     direction.z = sin(glm::radians(this->mRotation.x));
     this->mDirection = glm::normalize(direction);
+    this->invalidateView();
 
     #ifdef ALLOW_CAMERA_MOVEMENT
     // Roll:
@@ -32,6 +33,7 @@ void Camera::applyRotation() {
 }
 
 void Camera::recalcProjection() {
+    this->revision++;
     if (this->isOrthographic) {
         this->projectionMatrix = glm::ortho(
                     -aspectRatio * orthographicScale,
@@ -50,6 +52,11 @@ void Camera::updateOrbitDepth() {
     this->lookDepth = glm::length(this->mLocation);
 }
 
+void Camera::invalidateView() {
+    this->isViewDirty = true;
+    this->revision++;
+}
+
 Camera::Camera(int viewWidth, int viewHeight, float fov, float nearplane, float farplane) {
     this->viewWidth = viewWidth;
     this->viewHeight = viewHeight;
@@ -120,6 +127,34 @@ void Camera::rotateBy(float pitch, float roll, float yaw) {
     this->applyRotation();
 }
 
+void Camera::snapTo(CameraView view) {
+    switch (view) {
+        case VIEW_DEFAULT:
+            // 7.35889 m, -6.92579 m, 4.95831 m // X, -Y, Z
+            // 63.5593°, 0°, 46.6919° // pitch - 90, 0, yaw - 180
+            this->teleportTo(7.35889, 6.92579, 4.95831);
+            this->rotate(-26.4407, 0.0, -133.3081);
+            this->lookDepth = glm::length(this->mLocation);
+            this->setPerspective();
+            break;
+        case VIEW_TOP:
+            this->teleportTo(0, 0, this->lookDepth);
+            this->rotate(-89.9, 0, 0);
+            this->setOrtography();
+            break;
+        case VIEW_LEFT:
+            this->teleportTo(0, -this->lookDepth, 0);
+            this->rotate(0, 0, 0);
+            this->setOrtography();
+            break;
+        case VIEW_RIGHT:
+            this->teleportTo(this->lookDepth, 0, 0);
+            this->rotate(0, 0, -90);
+            this->setOrtography();
+            break;
+    }
+}
+
 void Camera::orbit(double deltaX, double deltaY) {
     glm::vec3 previousDirection(this->mDirection.x, this->mDirection.y, this->mDirection.z);
     // ...
@@ -128,6 +163,7 @@ void Camera::orbit(double deltaX, double deltaY) {
     // ...
     applyRotation();
     this->mLocation -= (this->mDirection - previousDirection) * this->lookDepth;
+    this->invalidateView();
 }
 void Camera::zoom(double deltaX, double deltaY) {
     double zoomAmount = glm::length(glm::vec2(deltaX, deltaY) / this->lookInSensitivity);
@@ -143,6 +179,7 @@ void Camera::teleportTo(float positionX, float positionY, float positionZ) {
     this->mLocation.y = positionY;
     this->mLocation.z = positionZ;
     updateOrbitDepth();
+    invalidateView();
 }
 
 void Camera::moveBy(float positionX, float positionY, float positionZ) {
@@ -150,6 +187,7 @@ void Camera::moveBy(float positionX, float positionY, float positionZ) {
     this->mLocation.y += positionY;
     this->mLocation.z += positionZ;
     updateOrbitDepth();
+    invalidateView();
 }
 
 void Camera::walk(float forwards, float sideways, float ascend) {
@@ -157,6 +195,7 @@ void Camera::walk(float forwards, float sideways, float ascend) {
     movement += glm::cross(this->mDirection, this->mUp) * sideways;
     movement.z += ascend;
     this->mLocation += movement;
+    this->invalidateView();
 }
 
 void Camera::walk(float forwards, float sideways, float ascend, glm::vec3 axisMask) {
@@ -164,6 +203,7 @@ void Camera::walk(float forwards, float sideways, float ascend, glm::vec3 axisMa
     movement += glm::cross(this->mDirection * axisMask, this->mUp) * sideways;
     movement.z += ascend;
     this->mLocation += movement;
+    this->invalidateView();
 }
 
 #ifdef DEBUG
@@ -178,7 +218,14 @@ glm::vec3 Camera::getCameraLocation() { return this->mLocation; }
 glm::vec3 Camera::getCameraRotation() { return this->mRotation; }
 glm::vec3 Camera::getCameraDirection() { return this->mDirection; }
 
-glm::mat4 Camera::getView() { return glm::lookAt(this->mLocation, this->mLocation + this->mDirection, this->mUp); }
+glm::mat4 Camera::getView() {
+    if (this->isViewDirty) {
+        this->viewMatrix = glm::lookAt(this->mLocation, this->mLocation + this->mDirection, this->mUp);
+        this->isViewDirty = false;
+    }
+    return this->viewMatrix;
+}
 glm::mat4 Camera::getProjection() { return this->projectionMatrix; }
+unsigned long Camera::getRevision() const { return this->revision; }
 
 float Camera::getFOV() const { return this->fieldOfView; }
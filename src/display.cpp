@@ -6,10 +6,11 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#define DISPLAY_IMPL
 #include "assets.h"
 #include "camera.h"
-#include "solver.h"
+#include "display.h"
+#include "mesh.h"
+#include "profiler.h"
 
 #include "config.h"
 
@@ -18,69 +19,20 @@
 #endif
 
 #ifdef USE_CDDLIB
-
-#include <quickhull/QuickHull.hpp>
-std::vector<size_t> getIndices(const std::vector<float>& vertices) {
-    quickhull::QuickHull<float> qh;
-    auto convexHull = qh.getConvexHull(vertices.data(), vertices.size(), true, false);
-    return convexHull.getIndexBuffer();
-}
-
-void generateSolutionObject(Object* object, const std::vector<float>& vertices) {
-    quickhull::QuickHull<float> qh;
-
-    auto convexHull = qh.getConvexHull(vertices.data(), vertices.size() / 3, true, true);
-    auto indexBuffer = convexHull.getIndexBuffer();
-
-    // Cast to <int> because for some reason OpenGL doesn't like anything other than
-    // *(u)int* in its index buffer
-    std::vector<unsigned int> indices(indexBuffer.begin(), indexBuffer.end());
-
-    object->setVertexData(vertices.data(), vertices.size(), indices.data(), indexBuffer.size());
+void generateSolutionObject(Object* object, const std::vector<float>& vertices, const FacetIncidence& facets, bool isBounded) {
+    std::vector<unsigned int> indices = getSolutionTriangles(vertices, facets, isBounded);
+    object->setVertexData(vertices.data(), vertices.size(), indices.data(), indices.size());
 }
 
-void generateSolutionWireframe(Object* object, const std::vector<float>& vertices, const std::vector<std::vector<int>>& adjacency) {
-    std::vector<unsigned int> indices;
-    int vertexCount = vertices.size() / 3;
-
-    // #ifdef DEBUG
-    // std::cout << "###############################\n";
-    // std::cout << "# BEGIN WIREFRAME GENERATION\n";
-    // std::cout << "###############################\n";
-
-    // std::cout << "Total vertices: " << vertexCount << '\n';
-    // std::cout << "Total adjacency entries: " << adjacency.size() << '\n';
-
-    // std::cout << "The pairing output will follow.\n";
-    // #endif
-
-    for (int vertex_a = 0; vertex_a < adjacency.size(); vertex_a++) {
-        const auto &adjacent = adjacency[vertex_a];
-        for (int vertex_b : adjacent) {
-            vertex_b -= 1;
-
-            // #ifdef DEBUG
-            // std::cout << "Pairing " << vertex_a << "<->" << vertex_b << '\n';
-            // #endif
-
-            if (vertex_a < vertex_b && vertex_b < vertexCount) {
-                indices.push_back(vertex_a);
-                indices.push_back(vertex_b);
-
-                // #ifdef DEBUG
-                // std::cout << " * It's a match!\n";
-                // #endif
-            }
-        }
-    }
-
+void generateSolutionWireframe(Object* object, const std::vector<float>& vertices, const Adjacency& adjacency) {
+    std::vector<unsigned int> indices = getSolutionEdges(vertices, adjacency);
     object->setVertexData(vertices.data(), vertices.size(), indices.data(), indices.size());
 }
 
 #else
-void generateSolutionObject(Object* object, const std::vector<float> vertices) {};
+void generateSolutionObject(Object* object, const std::vector<float>& vertices, const FacetIncidence& facets, bool isBounded) {};
 void generateSolutionVector(Object* object, const glm::vec3 solutionVector) {};
-void generateSolutionWireframe(Object* object, const std::vector<float> vertices, const std::vector<std::vector<int>> adjacency) {};
+void generateSolutionWireframe(Object* object, const std::vector<float>& vertices, const Adjacency& adjacency) {};
 #endif
 
 const glm::vec3 worldUp({0, 0, 1});
@@ -161,6 +113,11 @@ void Display::createShaders() {
     Display::planeShader.reset(new Shader("assets/plane.vert", "assets/plane.frag"));
     Display::solutionShader.reset(new Shader("assets/default.vert", "assets/default.frag"));
     #endif
+    planeGlobalScaleUniform = planeShader->getUniform<glm::mat4>("globalScale");
+    planeStripeScaleUniform = planeShader->getUniform<float>("stripeScale");
+    planeStripeWidthUniform = planeShader->getUniform<float>("stripeWidth");
+    solutionTransformUniform = solutionShader->getUniform<glm::mat4>("transform");
+    solutionColorUniform = solutionShader->getUniform<glm::vec3>("vertexColor");
 }
 
 void Display::recalculatePlane(int planeIndex) {
@@ -211,10 +168,14 @@ void Display::recalculatePlane(int planeIndex) {
 
     planeTransform = glm::scale(planeTransform, planeScale);
 
-    if (planeIndex == planeTransforms.size()) { planeTransforms.push_back(planeTransform); }
-    else { planeTransforms[planeIndex] = planeTransform; }
-
-    rebindAttributes();
+    if (planeIndex == planeInstances.size()) {
+        InstanceAttributePlane instance;
+        instance.positiveColor = constraintPositiveColors[planeIndex % constraintPositiveColors.size()];
+        instance.isVisible = 1.0f;
+        planeInstances.push_back(instance);
+    }
+    planeInstances[planeIndex].transform = planeTransform;
+    markDirty(planeIndex, planeIndex + 1);
 }
 
 void Display::recalculateOptimalPlan() {
@@ -233,18 +194,54 @@ void Display::recalculateOptimalPlan() {
     }
 }
 
-// TODO: Implement with instanced rendering
-void Display::rebindAttributes() {};
+void Display::markDirty(size_t from, size_t to) {
+    dirtyFrom = std::min(dirtyFrom, from);
+    dirtyTo = std::max(dirtyTo, to);
+}
+
+// Ships whatever changed since the last frame over to the instance buffer.
+// Only grows it, and by doubling, so adding planes one by one doesn't reallocate every time.
+void Display::rebindAttributes() {
+    if (planeInstances.size() > planeObject->getInstanceCapacity()) {
+        size_t capacity = std::max<size_t>(64, planeObject->getInstanceCapacity());
+        while (capacity < planeInstances.size()) capacity *= 2;
+        planeObject->setInstanceData(planeInstances.data(), planeInstances.size(), capacity);
+    } else if (dirtyFrom < dirtyTo) {
+        // Removals can leave the range hanging past the end, nobody draws those anyway
+        size_t dirtyEnd = std::min(dirtyTo, planeInstances.size());
+        if (dirtyFrom < dirtyEnd)
+            planeObject->updateInstanceData(planeInstances.data() + dirtyFrom, dirtyFrom, dirtyEnd - dirtyFrom);
+    }
+    dirtyFrom = SIZE_MAX;
+    dirtyTo = 0;
+}
+
+// A handful is plenty for flipping between a few setups, and they're small on the GPU anyway
+const size_t SOLUTION_MESH_CACHE_SIZE = 8;
+
 void Display::onSolutionSolved() {
-    if (!solutionWireframe) solutionWireframe.reset(new Object());
-    if (!solutionObject) solutionObject.reset(new Object());
-    generateSolutionWireframe(solutionWireframe.get(), solution.polyhedraVertices, solution.adjacency);
-    generateSolutionObject(solutionObject.get(), solution.polyhedraVertices);
+    auto cached = std::find_if(solutionMeshes.begin(), solutionMeshes.end(),
+        [this](const SolutionMeshes& meshes) { return meshes.regionId == solution.regionId; });
+    if (cached != solutionMeshes.end()) {
+        std::rotate(solutionMeshes.begin(), cached, cached + 1);
+    } else {
+        SolutionMeshes meshes { solution.regionId, std::make_shared<Object>(), std::make_shared<Object>() };
+        generateSolutionWireframe(meshes.wireframe.get(), solution.polyhedraVertices, solution.adjacency);
+        generateSolutionObject(meshes.volume.get(), solution.polyhedraVertices, solution.facets, solution.polyhedraRays.empty());
+        solutionMeshes.insert(solutionMeshes.begin(), meshes);
+        if (solutionMeshes.size() > SOLUTION_MESH_CACHE_SIZE) solutionMeshes.pop_back();
+    }
+    solutionObject = solutionMeshes.front().volume;
+    solutionWireframe = solutionMeshes.front().wireframe;
+    recalculateOptimalPlan();
+}
+
+// Region didn't change, so the meshes we've got uploaded are still good
+void Display::onOptimumUpdated() {
     recalculateOptimalPlan();
 }
 
 void Display::onPlaneAdded(int planeIndex) {
-    visibleEquations.push_back(true);
     recalculatePlane(planeIndex);
 }
 
@@ -252,14 +249,33 @@ void Display::onPlaneUpdated(int planeIndex) {
     recalculatePlane(planeIndex);
 }
 
+// Same swap as on the solver side: last one fills the gap
 void Display::onPlaneRemoved(int planeIndex) {
-    visibleEquations.erase(visibleEquations.begin() + planeIndex);
-    planeTransforms.erase(planeTransforms.begin() + planeIndex);
+    planeInstances[planeIndex] = planeInstances.back();
+    planeInstances.pop_back();
+    if (planeIndex == planeInstances.size()) return; // It was the last one, nothing moved
+    // Colours go by index, so the one that moved has to repaint itself
+    planeInstances[planeIndex].positiveColor = constraintPositiveColors[planeIndex % constraintPositiveColors.size()];
+    markDirty(planeIndex, planeIndex + 1);
+}
+
+void Display::onPlanesCompacted(const std::vector<int>& survivors) {
+    // survivors[i] >= i, so moving front to back never steps on anything still needed
+    size_t firstMoved = survivors.size();
+    for (size_t planeIndex = 0; planeIndex < survivors.size(); planeIndex++) {
+        if (survivors[planeIndex] == static_cast<int>(planeIndex)) continue;
+        firstMoved = std::min(firstMoved, planeIndex);
+        planeInstances[planeIndex] = planeInstances[survivors[planeIndex]];
+        planeInstances[planeIndex].positiveColor = constraintPositiveColors[planeIndex % constraintPositiveColors.size()];
+    }
+    planeInstances.resize(survivors.size());
+    markDirty(firstMoved, survivors.size());
 }
 
 void Display::onReset() {
-    planeTransforms.clear();
-    visibleEquations.clear();
+    planeInstances.clear();
+    dirtyFrom = SIZE_MAX;
+    dirtyTo = 0;
 }
 
 //  public:
@@ -268,7 +284,6 @@ Display::Display() {
     if (!Display::planeObject || !Display::vectorDisplay) createObjects();
     if (!Display::planeShader || !Display::solutionShader) createShaders();
     this->showPlanesAtAll = true;
-    this->visibleEquations = std::vector<bool>();
 };
 
 void Display::setScale(double scale) {
@@ -276,52 +291,45 @@ void Display::setScale(double scale) {
     this->globalScaleTransform = glm::scale(glm::mat4(1), glm::vec3(1 / this->globalScale));
 }
 
-void Display::render(Camera* camera) {
-    if (planeTransforms.empty()) return;
+bool Display::isPlaneVisible(int planeIndex) const {
+    return planeInstances[planeIndex].isVisible != 0.0f;
+}
+
+void Display::setPlaneVisible(int planeIndex, bool isVisible) {
+    planeInstances[planeIndex].isVisible = isVisible ? 1.0f : 0.0f;
+    markDirty(planeIndex, planeIndex + 1);
+}
+
+void Display::invalidatePlaneColors() {
+    for (size_t planeIndex = 0; planeIndex < planeInstances.size(); planeIndex++)
+        planeInstances[planeIndex].positiveColor = constraintPositiveColors[planeIndex % constraintPositiveColors.size()];
+    markDirty(0, planeInstances.size());
+}
+
+void Display::render() {
+    if (planeInstances.empty()) return;
     // glBindVertexArray(planeObject->objectData);
     planeShader->activate();
-    planeShader->setTransform(camera->getProjection(), camera->getView());
-    /** TODO: Instanced rendering of plane limits
-     * This will require:
-     * - The plane transformation buffer [GL]
-     *   All the mat3s are collected there
-     * - Said buffer to be resizeable and dynamically updateable
-     *   Not every frame, but could be often
-     * - Meaning we should somehow rebind it
-     *   OpenGL allows for linking *side*("unrelated") buffers to the VAO
-     *   So we could have the vertex data buffer with our glorious four vertices
-     *   And another one, with the matrix transforms
-     * - Passing matrix transforms via vertex attributes
-     *   Which isn't that bad, as they're involved in vertex stage, which uses them either way
-     *
-     * I'm mostly concerned about re-creating the MBO (matrix buffer object)
-     * Like, do we have to re-link it to the VAO? What happens to the old link?
-     * Do we have to re-link the whole object?
-     */
-    // glDrawElementsInstanced(GL_TRIANGLES, planeObject->vertexCount, GL_UNSIGNED_INT, 0, planeTransforms.size());
     if (showPlanesAtAll) {
-    this->planeShader->setUniform("globalScale", globalScaleTransform);
-    for (int planeIndex = 0; planeIndex < planeTransforms.size(); planeIndex++) {
-        if (!visibleEquations[planeIndex]) continue;
-        this->planeShader->setUniform("planeTransform", planeTransforms[planeIndex]);
-        this->planeShader->setUniform("stripeScale", stripeFrequency);
-        this->planeShader->setUniform("stripeWidth", stripeWidth);
-        this->planeShader->setUniform("positiveColor", constraintPositiveColors[planeIndex % constraintPositiveColors.size()]);
-        this->planeShader->setUniform("negativeColor", glm::vec3(1) - constraintPositiveColors[planeIndex % constraintPositiveColors.size()]);
-        planeObject->bindForDraw();
-    }
+    ProfileScope planesScope(profiler, PROFILE_PLANES);
+    rebindAttributes();
+    // Everything per-plane lives in the instance buffer, so it's one draw no matter how many there are
+    this->planeShader->setUniform(planeGlobalScaleUniform, globalScaleTransform);
+    this->planeShader->setUniform(planeStripeScaleUniform, stripeFrequency);
+    this->planeShader->setUniform(planeStripeWidthUniform, stripeWidth);
+    planeObject->bindForDrawInstanced(planeInstances.size());
     }
 
     if (this->solution.isSolved && this->solutionObject) {
+    ProfileScope solutionScope(profiler, PROFILE_SOLUTION);
     this->solutionShader->activate();
-    this->solutionShader->setTransform(camera->getProjection(), camera->getView());
-    this->solutionShader->setUniform("transform", globalScaleTransform);
+    this->solutionShader->setUniform(solutionTransformUniform, globalScaleTransform);
     if (this->showSolutionVolume) {
-        this->solutionShader->setUniform("vertexColor", solutionColor);
+        this->solutionShader->setUniform(solutionColorUniform, solutionColor);
         this->solutionObject->bindForDraw();
     }
     if (this->showSolutionWireframe) {
-        this->solutionShader->setUniform("vertexColor", solutionWireframeColor);
+        this->solutionShader->setUniform(solutionColorUniform, solutionWireframeColor);
         glLineWidth(this->wireThickness);
         glEnable(GL_POLYGON_OFFSET_LINE);
         glPolygonOffset(-1.0, -11.0);
@@ -332,7 +340,7 @@ void Display::render(Camera* camera) {
         glLineWidth(1.0);
     }
     if (this->showSolutionVector) {
-        this->solutionShader->setUniform("vertexColor", this->solutionVectorColor);
+        this->solutionShader->setUniform(solutionColorUniform, this->solutionVectorColor);
 
         glm::vec3 vectorBaseScale = glm::vec3(
             this->vectorWidth,
@@ -350,14 +358,14 @@ void Display::render(Camera* camera) {
         vectorBaseTransform = vectorBaseTransform * this->optimalPlanTransform;
         vectorBaseTransform = glm::scale(vectorBaseTransform, vectorBaseScale);
 
-        this->solutionShader->setUniform("transform", vectorBaseTransform);
+        this->solutionShader->setUniform(solutionTransformUniform, vectorBaseTransform);
         vectorDisplay->bindForDrawSlice(0, 36);
 
         glm::mat4 vectorArrowTransform = globalScaleTransform; // even before anything, we apply global scale
         vectorArrowTransform = glm::translate(vectorArrowTransform, this->solution.optimalVector); // We move first
         vectorArrowTransform = vectorArrowTransform * this->optimalPlanTransform; // Then we reorient it to look in the direction
         vectorArrowTransform = glm::scale(vectorArrowTransform, vectorArrowScale); // And only then we scale
-        this->solutionShader->setUniform("transform", vectorArrowTransform);
+        this->solutionShader->setUniform(solutionTransformUniform, vectorArrowTransform);
         vectorDisplay->bindForDrawSlice(36, 18);
     }
     }
@@ -367,6 +375,7 @@ Display::~Display() {
     Display::solutionShader.reset();
     Display::solutionObject.reset();
     Display::solutionWireframe.reset();
+    Display::solutionMeshes.clear();
 
     Display::vectorDisplay.reset();
 
@@ -433,6 +442,14 @@ void WorldGridDisplay::createShaders() {
     WorldGridDisplay::gridShader.reset(new Shader("assets/grid.vert", "assets/grid.frag"));
     WorldGridDisplay::axisShader.reset(new Shader("assets/axis.vert", "assets/axis.frag"));
     #endif
+    gridScaleUniform = gridShader->getUniform<float>("gridScale");
+    gridStrokeWidthUniform = gridShader->getUniform<float>("strokeWidth");
+    // Never change, so they go in once and stay with the program
+    gridShader->activate();
+    gridShader->setUniform("gridOffset[0]", glm::vec2({ 1.0,  1.0}));
+    gridShader->setUniform("gridOffset[1]", glm::vec2({ 1.0, -1.0}));
+    gridShader->setUniform("gridOffset[2]", glm::vec2({-1.0,  1.0}));
+    gridShader->setUniform("gridOffset[3]", glm::vec2({-1.0, -1.0}));
 }
 
 // class WorldGridDisplay
@@ -459,32 +476,27 @@ double WorldGridDisplay::getComputedScale() {
     return pow(10, this->scaleExponent) * this->gridScale;
 }
 
-void WorldGridDisplay::render(glm::mat4 view, glm::mat4 projection) {
+void WorldGridDisplay::render() {
+    ProfileScope gridScope(profiler, PROFILE_GRID);
     if (gridEnabled) {
         gridShader->activate();
-        gridShader->setTransform(projection, view);
-        gridShader->setUniform("gridScale", gridScale);
-        gridShader->setUniform("strokeWidth", gridWidth);
-        gridShader->setUniform("gridOffset[0]", glm::vec2({ 1.0,  1.0}));
-        gridShader->setUniform("gridOffset[1]", glm::vec2({ 1.0, -1.0}));
-        gridShader->setUniform("gridOffset[2]", glm::vec2({-1.0,  1.0}));
-        gridShader->setUniform("gridOffset[3]", glm::vec2({-1.0, -1.0}));
+        gridShader->setUniform(gridScaleUniform, gridScale);
+        gridShader->setUniform(gridStrokeWidthUniform, gridWidth);
 
         gridObject->bindForDrawInstanced(4);
 
         if (gridScale >= 1.0) {
-            gridShader->setUniform("gridScale", gridScale / 10);
-            gridShader->setUniform("strokeWidth", 0.05 - gridWidth / gridScale);
+            gridShader->setUniform(gridScaleUniform, gridScale / 10);
+            gridShader->setUniform(gridStrokeWidthUniform, 0.05f - gridWidth / gridScale);
             gridObject->bindForDrawInstanced(4);
         } else {
-            gridShader->setUniform("gridScale", gridScale * 10);
-            gridShader->setUniform("strokeWidth", 0.05 - gridWidth * gridScale);
+            gridShader->setUniform(gridScaleUniform, gridScale * 10);
+            gridShader->setUniform(gridStrokeWidthUniform, 0.05f - gridWidth * gridScale);
             gridObject->bindForDrawInstanced(4);
         }
     }
     if (axisEnabled) {
         axisShader->activate();
-        axisShader->setTransform(projection, view);
         axisObject->bindForDraw(GL_LINES);
     }
 }
@@ -0,0 +1,269 @@
+#include "halfspace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+#include "seidel.h"
+#include "config.h"
+
+void buildFacets(const std::vector<float>& vertices, const std::vector<glm::dvec3>& normals, FacetIncidence& facets) {
+    std::vector<uint32_t> offsets { 0 };
+    std::vector<uint32_t> facetVertices;
+    std::vector<uint32_t> planes;
+    std::set<std::vector<uint32_t>> seen;
+    std::vector<std::pair<double, uint32_t>> byAngle;
+    facetVertices.reserve(facets.vertices.size());
+
+    auto vertexAt = [&vertices](uint32_t vertex) {
+        return glm::dvec3(vertices[3 * vertex], vertices[3 * vertex + 1], vertices[3 * vertex + 2]);
+    };
+
+    for (size_t facet = 0; facet < facets.getFacetCount(); facet++) {
+        std::vector<uint32_t> members(facets.vertices.begin() + facets.offsets[facet], facets.vertices.begin() + facets.offsets[facet + 1]);
+        std::sort(members.begin(), members.end());
+        members.erase(std::unique(members.begin(), members.end()), members.end());
+        if (members.size() < 3 || !seen.insert(members).second) continue;
+
+        glm::dvec3 normal = normals[facets.planes[facet]];
+        glm::dvec3 center(0);
+        for (uint32_t vertex : members) center += vertexAt(vertex);
+        center /= static_cast<double>(members.size());
+        // Any axis not too close to the normal will do for the in-plane basis
+        glm::dvec3 axis = std::abs(normal.x) < std::abs(normal.y)
+            ? (std::abs(normal.x) < std::abs(normal.z) ? glm::dvec3(1, 0, 0) : glm::dvec3(0, 0, 1))
+            : (std::abs(normal.y) < std::abs(normal.z) ? glm::dvec3(0, 1, 0) : glm::dvec3(0, 0, 1));
+        glm::dvec3 u = glm::normalize(glm::cross(normal, axis));
+        glm::dvec3 v = glm::cross(glm::normalize(normal), u);
+
+        byAngle.clear();
+        for (uint32_t vertex : members) {
+            glm::dvec3 offset = vertexAt(vertex) - center;
+            byAngle.push_back({ std::atan2(glm::dot(offset, v), glm::dot(offset, u)), vertex });
+        }
+        std::sort(byAngle.begin(), byAngle.end());
+        for (const auto& vertex : byAngle) facetVertices.push_back(vertex.second);
+        offsets.push_back(facetVertices.size());
+        planes.push_back(facets.planes[facet]);
+    }
+
+    if (planes.empty()) offsets.clear();
+    facets.offsets.swap(offsets);
+    facets.vertices.swap(facetVertices);
+    facets.planes.swap(planes);
+}
+
+#ifdef USE_CDDLIB
+#include <quickhull/QuickHull.hpp>
+
+namespace {
+
+// How close the dual hull may come to the origin, i.e. 1 / (how far the region may reach)
+const double INTERIOR_EPSILON = 1e-9;
+// Faces this close in the primal are one and the same vertex
+const double COPLANAR_EPSILON = 1e-7;
+// Anything thinner than that isn't a face, it's quickhull stitching a flat patch together
+const double SLIVER_EPSILON = 1e-12;
+// Coordinates this small (relative to where the region is) are zeroes that picked up some noise
+const double SNAP_EPSILON = 1e-12;
+
+int findRoot(std::vector<int>& parent, int node) {
+    while (parent[node] != node) {
+        parent[node] = parent[parent[node]];
+        node = parent[node];
+    }
+    return node;
+}
+
+void joinRoots(std::vector<int>& parent, int first, int second) {
+    first = findRoot(parent, first);
+    second = findRoot(parent, second);
+    if (first != second) parent[std::max(first, second)] = std::min(first, second);
+}
+
+} // namespace
+
+/**
+ * The trick is polarity: with the origin strictly inside the region, every plane A·x <= B
+ * maps to a point A / B, and the region's vertices are exactly the faces of the convex hull
+ * of those points. So the whole enumeration is:
+ * 1. find some point well inside (Chebyshev center, one LP) and move it to the origin
+ * 2. dualize the planes into points
+ * 3. one quickhull run
+ * 4. turn hull faces back into vertices, faces sharing an edge into adjacent vertices
+ * Planes that don't touch the region end up inside the hull and drop out on their own.
+ * More than three planes through a vertex show up as several coplanar triangles, which get glued back together.
+ */
+bool intersectHalfspaces(const std::vector<glm::dvec4>& halfspaces, std::vector<float>& vertices, Adjacency& adjacency, FacetIncidence& facets) {
+    if (halfspaces.size() < 4) return false; // Can't close anything in 3D with less
+
+    SeidelResult center = seidelChebyshevCenter(halfspaces);
+    if (center.status != SEIDEL_OPTIMAL) return false;
+    double scale = 1 + std::max(std::abs(center.point.x), std::max(std::abs(center.point.y), std::abs(center.point.z)));
+    if (center.value <= INTERIOR_EPSILON * scale) return false; // Flat or empty
+
+    std::vector<double> dualPoints;
+    std::vector<uint32_t> dualHalfspaces; // Which halfspace each point came from
+    dualPoints.reserve(halfspaces.size() * 3);
+    dualHalfspaces.reserve(halfspaces.size());
+    for (size_t index = 0; index < halfspaces.size(); index++) {
+        const glm::dvec4& halfspace = halfspaces[index];
+        glm::dvec3 normal = glm::dvec3(halfspace);
+        if (normal == glm::dvec3(0)) continue; // 0 <= B, the center already vouched for it
+        dualHalfspaces.push_back(index);
+        // Strictly positive, the center is at least its radius away from every plane
+        glm::dvec3 dual = normal / (halfspace.w - glm::dot(normal, center.point));
+        dualPoints.push_back(dual.x);
+        dualPoints.push_back(dual.y);
+        dualPoints.push_back(dual.z);
+    }
+
+    quickhull::QuickHull<double> qh;
+    auto convexHull = qh.getConvexHull(dualPoints.data(), dualPoints.size() / 3, true, true);
+    const auto& indexBuffer = convexHull.getIndexBuffer();
+    size_t triangleCount = indexBuffer.size() / 3;
+    if (triangleCount < 4) return false;
+
+    auto dualPoint = [&dualPoints](size_t index) {
+        return glm::dvec3(dualPoints[3 * index], dualPoints[3 * index + 1], dualPoints[3 * index + 2]);
+    };
+
+    // Hull face n·q = 1 is the vertex at n (relative to the center)
+    std::vector<glm::dvec3> faceVertices(triangleCount);
+    std::vector<bool> isSliver(triangleCount, false);
+    double orientation = 0;
+    for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+        glm::dvec3 first = dualPoint(indexBuffer[3 * triangle]);
+        glm::dvec3 normal = glm::cross(dualPoint(indexBuffer[3 * triangle + 1]) - first, dualPoint(indexBuffer[3 * triangle + 2]) - first);
+        double normalLength = glm::length(normal);
+        if (normalLength <= SLIVER_EPSILON * glm::dot(first, first)) {
+            isSliver[triangle] = true;
+            continue;
+        }
+        double offset = glm::dot(normal, first);
+        // Origin on (or outside of) the hull means the region is open that way
+        if (std::abs(offset) <= INTERIOR_EPSILON * normalLength) return false;
+        if (orientation == 0) orientation = offset;
+        if ((offset > 0) != (orientation > 0)) return false;
+        faceVertices[triangle] = normal / offset;
+    }
+
+    // Every edge is shared by exactly two triangles on a closed hull
+    std::unordered_map<uint64_t, std::pair<int, int>> edges;
+    edges.reserve(triangleCount * 3 / 2);
+    for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+        for (int corner = 0; corner < 3; corner++) {
+            uint64_t from = indexBuffer[3 * triangle + corner];
+            uint64_t to = indexBuffer[3 * triangle + (corner + 1) % 3];
+            uint64_t key = (std::min(from, to) << 32) | std::max(from, to);
+            auto edge = edges.find(key);
+            if (edge == edges.end()) edges.emplace(key, std::make_pair(static_cast<int>(triangle), -1));
+            else if (edge->second.second < 0) edge->second.second = triangle;
+            else return false; // Three faces on one edge, that's no hull I know of
+        }
+    }
+
+    std::vector<int> parent(triangleCount);
+    for (size_t triangle = 0; triangle < triangleCount; triangle++) parent[triangle] = triangle;
+    for (const auto& edge : edges) {
+        int first = edge.second.first;
+        int second = edge.second.second;
+        if (second < 0) return false; // Not closed, quickhull gave up on us
+        glm::dvec3 difference = faceVertices[first] - faceVertices[second];
+        bool isSameVertex = isSliver[first] || isSliver[second]
+            || glm::length(difference) <= COPLANAR_EPSILON * (1 + glm::length(faceVertices[first]));
+        if (isSameVertex) joinRoots(parent, first, second);
+    }
+
+    // Roots become vertices, positions averaged over their (non-sliver) faces
+    std::vector<int> vertexIndex(triangleCount, -1);
+    std::vector<glm::dvec3> vertexSums;
+    std::vector<int> vertexFaces;
+    for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+        int root = findRoot(parent, triangle);
+        if (vertexIndex[root] < 0) {
+            vertexIndex[root] = vertexSums.size();
+            vertexSums.push_back(glm::dvec3(0));
+            vertexFaces.push_back(0);
+        }
+        vertexIndex[triangle] = vertexIndex[root];
+        if (isSliver[triangle]) continue;
+        vertexSums[vertexIndex[triangle]] += faceVertices[triangle];
+        vertexFaces[vertexIndex[triangle]]++;
+    }
+
+    vertices.clear();
+    vertices.reserve(vertexSums.size() * 3);
+    for (size_t vertex = 0; vertex < vertexSums.size(); vertex++) {
+        if (vertexFaces[vertex] == 0) {
+            // Nothing but slivers, can't place it. Half a vertex list is worse than none
+            vertices.clear();
+            return false;
+        }
+        glm::dvec3 position = center.point + vertexSums[vertex] / static_cast<double>(vertexFaces[vertex]);
+        // Round-off around zero would otherwise survive the trip to float as 1e-17 and such
+        for (int axis = 0; axis < 3; axis++) {
+            if (std::abs(position[axis]) <= SNAP_EPSILON * scale) position[axis] = 0;
+        }
+        vertices.push_back(position.x);
+        vertices.push_back(position.y);
+        vertices.push_back(position.z);
+    }
+
+    // Both directions of every edge as (from, to) keys. Glued faces hand out the same edge
+    // several times over, sorting lines the duplicates up and puts the rows in order to boot
+    std::vector<uint64_t> directedEdges;
+    directedEdges.reserve(edges.size() * 2);
+    for (const auto& edge : edges) {
+        uint64_t first = vertexIndex[edge.second.first];
+        uint64_t second = vertexIndex[edge.second.second];
+        if (first == second) continue;
+        directedEdges.push_back((first << 32) | second);
+        directedEdges.push_back((second << 32) | first);
+    }
+    std::sort(directedEdges.begin(), directedEdges.end());
+    directedEdges.erase(std::unique(directedEdges.begin(), directedEdges.end()), directedEdges.end());
+
+    adjacency.offsets.assign(vertexSums.size() + 1, 0);
+    adjacency.neighbours.resize(directedEdges.size());
+    for (size_t edge = 0; edge < directedEdges.size(); edge++) {
+        adjacency.offsets[(directedEdges[edge] >> 32) + 1]++;
+        adjacency.neighbours[edge] = static_cast<uint32_t>(directedEdges[edge]);
+    }
+    for (size_t vertex = 0; vertex < vertexSums.size(); vertex++) adjacency.offsets[vertex + 1] += adjacency.offsets[vertex];
+
+    // And the other way around: a dual point is a face, the triangles around it are its vertices.
+    // Same sort-and-unique as the edges, keyed (halfspace, vertex) this time
+    std::vector<uint64_t> incidence;
+    incidence.reserve(indexBuffer.size());
+    for (size_t corner = 0; corner < indexBuffer.size(); corner++) {
+        uint64_t halfspace = dualHalfspaces[indexBuffer[corner]];
+        incidence.push_back((halfspace << 32) | static_cast<uint32_t>(vertexIndex[corner / 3]));
+    }
+    std::sort(incidence.begin(), incidence.end());
+    incidence.erase(std::unique(incidence.begin(), incidence.end()), incidence.end());
+
+    facets.clear();
+    std::vector<glm::dvec3> normals(halfspaces.size());
+    for (size_t index = 0; index < halfspaces.size(); index++) normals[index] = glm::dvec3(halfspaces[index]);
+    for (uint64_t entry : incidence) {
+        uint32_t halfspace = static_cast<uint32_t>(entry >> 32);
+        if (facets.planes.empty() || facets.planes.back() != halfspace) {
+            facets.offsets.push_back(facets.vertices.size());
+            facets.planes.push_back(halfspace);
+        }
+        facets.vertices.push_back(static_cast<uint32_t>(entry));
+    }
+    facets.offsets.push_back(facets.vertices.size());
+    buildFacets(vertices, normals, facets);
+    return true;
+}
+
+#else
+bool intersectHalfspaces(const std::vector<glm::dvec4>& halfspaces, std::vector<float>& vertices, Adjacency& adjacency, FacetIncidence& facets) {
+    return false;
+}
+#endif
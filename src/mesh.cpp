@@ -0,0 +1,53 @@
+#include "mesh.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "config.h"
+
+#ifdef USE_CDDLIB
+#include <quickhull/QuickHull.hpp>
+#endif
+
+std::vector<unsigned int> getSolutionTriangles(const std::vector<float>& vertices, const FacetIncidence& facets, bool isBounded) {
+    std::vector<unsigned int> indices;
+    if (isBounded && facets.getFacetCount() > 0) {
+        // A face with n vertices is n - 2 triangles
+        indices.reserve((facets.vertices.size() - 2 * facets.getFacetCount()) * 3);
+        for (size_t facet = 0; facet < facets.getFacetCount(); facet++) {
+            uint32_t first = facets.offsets[facet];
+            for (uint32_t corner = first + 1; corner + 1 < facets.offsets[facet + 1]; corner++) {
+                indices.push_back(facets.vertices[first]);
+                indices.push_back(facets.vertices[corner]);
+                indices.push_back(facets.vertices[corner + 1]);
+            }
+        }
+        return indices;
+    }
+
+    #ifdef USE_CDDLIB
+    quickhull::QuickHull<float> qh;
+    auto convexHull = qh.getConvexHull(vertices.data(), vertices.size() / 3, true, true);
+    auto indexBuffer = convexHull.getIndexBuffer();
+    // Cast to <int> because for some reason OpenGL doesn't like anything other than
+    // *(u)int* in its index buffer
+    indices.assign(indexBuffer.begin(), indexBuffer.end());
+    #endif
+    return indices;
+}
+
+std::vector<unsigned int> getSolutionEdges(const std::vector<float>& vertices, const Adjacency& adjacency) {
+    std::vector<unsigned int> indices;
+    indices.reserve(adjacency.neighbours.size());
+    uint32_t vertexCount = std::min(adjacency.getVertexCount(), vertices.size() / 3);
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++) {
+        for (uint32_t neighbour = adjacency.offsets[vertex]; neighbour < adjacency.offsets[vertex + 1]; neighbour++) {
+            uint32_t other = adjacency.neighbours[neighbour];
+            if (vertex < other && other < vertexCount) {
+                indices.push_back(vertex);
+                indices.push_back(other);
+            }
+        }
+    }
+    return indices;
+}
@@ -0,0 +1,209 @@
+#include "pngwriter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+const int WINDOW_SIZE = 32768;
+const int MIN_MATCH = 3;
+const int MAX_MATCH = 258;
+const int HASH_BITS = 15;
+const int MAX_CHAIN = 16; // How many earlier spots we try before settling
+
+const uint16_t lengthBases[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const uint8_t lengthExtraBits[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+const uint16_t distanceBases[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+const uint8_t distanceExtraBits[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// Deflate wants bits least significant first, except Huffman codes, which go most significant first
+class BitWriter {
+    private:
+    std::vector<unsigned char>& output;
+    uint32_t buffer = 0;
+    int bufferedBits = 0;
+
+    public:
+    BitWriter(std::vector<unsigned char>& output) : output(output) {}
+
+    void write(uint32_t bits, int count) {
+        buffer |= bits << bufferedBits;
+        bufferedBits += count;
+        while (bufferedBits >= 8) {
+            output.push_back(buffer & 0xFF);
+            buffer >>= 8;
+            bufferedBits -= 8;
+        }
+    }
+
+    void writeCode(uint32_t code, int length) {
+        uint32_t reversed = 0;
+        for (int bit = 0; bit < length; bit++) reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+        write(reversed, length);
+    }
+
+    void flush() { if (bufferedBits > 0) write(0, 8 - bufferedBits); }
+};
+
+void writeLiteral(BitWriter& bits, int symbol) {
+    if (symbol < 144) bits.writeCode(0x30 + symbol, 8);
+    else if (symbol < 256) bits.writeCode(0x190 + symbol - 144, 9);
+    else if (symbol < 280) bits.writeCode(symbol - 256, 7);
+    else bits.writeCode(0xC0 + symbol - 280, 8);
+}
+
+void writeMatch(BitWriter& bits, int length, int distance) {
+    int lengthCode = 28;
+    while (lengthBases[lengthCode] > length) lengthCode--;
+    writeLiteral(bits, 257 + lengthCode);
+    bits.write(length - lengthBases[lengthCode], lengthExtraBits[lengthCode]);
+
+    int distanceCode = 29;
+    while (distanceBases[distanceCode] > distance) distanceCode--;
+    bits.writeCode(distanceCode, 5);
+    bits.write(distance - distanceBases[distanceCode], distanceExtraBits[distanceCode]);
+}
+
+uint32_t hashAt(const std::vector<unsigned char>& data, size_t position) {
+    uint32_t value = data[position] | (data[position + 1] << 8) | (data[position + 2] << 16);
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+std::vector<unsigned char> zlibCompress(const std::vector<unsigned char>& data) {
+    std::vector<unsigned char> output = { 0x78, 0x01 };
+    BitWriter bits(output);
+    bits.write(1, 1); // Last block
+    bits.write(1, 2); // Fixed Huffman
+
+    std::vector<int32_t> head(1 << HASH_BITS, -1);
+    std::vector<int32_t> previous(WINDOW_SIZE, -1);
+    auto insert = [&](size_t position) {
+        uint32_t hash = hashAt(data, position);
+        previous[position % WINDOW_SIZE] = head[hash];
+        head[hash] = position;
+    };
+
+    size_t position = 0;
+    while (position < data.size()) {
+        int bestLength = 0;
+        int bestDistance = 0;
+        if (position + MIN_MATCH <= data.size()) {
+            int32_t candidate = head[hashAt(data, position)];
+            int maxLength = std::min<size_t>(MAX_MATCH, data.size() - position);
+            for (int tries = 0; candidate >= 0 && tries < MAX_CHAIN; tries++) {
+                if (position - candidate > WINDOW_SIZE) break;
+                int length = 0;
+                while (length < maxLength && data[candidate + length] == data[position + length]) length++;
+                if (length > bestLength) {
+                    bestLength = length;
+                    bestDistance = position - candidate;
+                    if (length == maxLength) break;
+                }
+                int32_t earlier = previous[candidate % WINDOW_SIZE];
+                if (earlier >= candidate) break; // Slot got reused by something newer
+                candidate = earlier;
+            }
+        }
+
+        if (bestLength >= MIN_MATCH) {
+            writeMatch(bits, bestLength, bestDistance);
+            for (int step = 0; step < bestLength; step++, position++) {
+                if (position + MIN_MATCH <= data.size()) insert(position);
+            }
+        } else {
+            writeLiteral(bits, data[position]);
+            if (position + MIN_MATCH <= data.size()) insert(position);
+            position++;
+        }
+    }
+    writeLiteral(bits, 256);
+    bits.flush();
+
+    uint32_t adlerA = 1, adlerB = 0;
+    for (unsigned char byte : data) {
+        adlerA = (adlerA + byte) % 65521;
+        adlerB = (adlerB + adlerA) % 65521;
+    }
+    uint32_t adler = (adlerB << 16) | adlerA;
+    for (int shift = 24; shift >= 0; shift -= 8) output.push_back((adler >> shift) & 0xFF);
+    return output;
+}
+
+uint32_t crc32(const unsigned char* data, size_t size, uint32_t crc = 0) {
+    static uint32_t table[256] = {};
+    if (table[1] == 0) {
+        for (uint32_t entry = 0; entry < 256; entry++) {
+            uint32_t value = entry;
+            for (int bit = 0; bit < 8; bit++) value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            table[entry] = value;
+        }
+    }
+    crc = ~crc;
+    for (size_t index = 0; index < size; index++) crc = table[(crc ^ data[index]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void appendBigEndian(std::vector<unsigned char>& output, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) output.push_back((value >> shift) & 0xFF);
+}
+
+void appendChunk(std::vector<unsigned char>& output, const char* type, const std::vector<unsigned char>& data) {
+    appendBigEndian(output, data.size());
+    size_t typeStart = output.size();
+    output.insert(output.end(), type, type + 4);
+    output.insert(output.end(), data.begin(), data.end());
+    appendBigEndian(output, crc32(output.data() + typeStart, output.size() - typeStart));
+}
+
+} // namespace
+
+std::vector<unsigned char> encodePNG(int width, int height, const unsigned char* rgba) {
+    const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<unsigned char> png(signature, signature + 8);
+
+    std::vector<unsigned char> header;
+    appendBigEndian(header, width);
+    appendBigEndian(header, height);
+    header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8 bits per channel, RGBA, deflate, adaptive filters, no interlace
+    appendChunk(png, "IHDR", header);
+
+    // Every row starts with its filter, "Up" makes flat vertical runs into runs of zeroes
+    size_t stride = static_cast<size_t>(width) * 4;
+    std::vector<unsigned char> filtered;
+    filtered.reserve((stride + 1) * height);
+    for (int row = 0; row < height; row++) {
+        const unsigned char* line = rgba + stride * row;
+        if (row == 0) {
+            filtered.push_back(0);
+            filtered.insert(filtered.end(), line, line + stride);
+            continue;
+        }
+        filtered.push_back(2);
+        for (size_t byte = 0; byte < stride; byte++) filtered.push_back(line[byte] - line[byte - stride]);
+    }
+    appendChunk(png, "IDAT", zlibCompress(filtered));
+    appendChunk(png, "IEND", {});
+    return png;
+}
+
+void writePNG(const std::string& path, int width, int height, const unsigned char* rgba) {
+    std::vector<unsigned char> png = encodePNG(width, height, rgba);
+    std::ofstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Can't open " + path + " for writing");
+    file.write(reinterpret_cast<const char*>(png.data()), png.size());
+    if (!file) throw std::runtime_error("Failed writing " + path);
+}
@@ -0,0 +1,93 @@
+#include "problem.h"
+
+#include <ios>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+std::runtime_error parseError(int lineNumber, const std::string& what) {
+    return std::runtime_error("Line " + std::to_string(lineNumber) + ": " + what);
+}
+
+const char* const equationSigns[3] = { "<=", ">=", "=" };
+} // namespace
+
+bool readProblem(std::istream& input, LinearProgrammingProblem& problem, int& lineNumber) {
+    problem.reset();
+    problem.doMinimize = true;
+
+    bool hasAnything = false;
+    bool hasObjective = false;
+    std::string line;
+    while (std::getline(input, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        std::istringstream statement(line);
+        std::string first;
+        if (!(statement >> first)) continue; // Blank
+        if (first == "---") {
+            if (hasAnything) return true;
+            continue; // Leading separators don't make empty problems
+        }
+        hasAnything = true;
+
+        if (first == "max" || first == "maximize" || first == "min" || first == "minimize") {
+            if (hasObjective) throw parseError(lineNumber, "second objective");
+            glm::vec4 objective(0);
+            for (int axis = 0; axis < 3; axis++) {
+                if (!(statement >> objective[axis])) throw parseError(lineNumber, "objective needs three coefficients");
+            }
+            if (!(statement >> objective.w)) {
+                if (!statement.eof()) throw parseError(lineNumber, "objective constant isn't a number");
+                objective.w = 0;
+            }
+            problem.objectiveFunction = objective;
+            problem.doMinimize = first[1] == 'i';
+            hasObjective = true;
+        } else {
+            glm::vec4 plane;
+            std::string sign;
+            size_t parsedLength = 0;
+            try { plane.x = std::stof(first, &parsedLength); }
+            catch (std::logic_error &error) { parsedLength = 0; }
+            // stof() is happy to stop halfway, "1abc" isn't a number though
+            if (parsedLength != first.size()) throw parseError(lineNumber, "expected a constraint or an objective, got \"" + first + "\"");
+            if (!(statement >> plane.y >> plane.z >> sign >> plane.w)) throw parseError(lineNumber, "constraint should look like A1 A2 A3 <= B");
+
+            EquationType type;
+            if (sign == "<=") type = EquationType::LESS_EQUAL_THAN;
+            else if (sign == ">=") type = EquationType::GREATER_EQUAL_THAN;
+            else if (sign == "=" || sign == "==") type = EquationType::EQUAL_TO;
+            else throw parseError(lineNumber, "unknown sign \"" + sign + "\"");
+            problem.addLimitPlane(plane, type);
+        }
+
+        std::string rest;
+        statement.clear(); // Objective without a constant ran into the end already
+        if (statement >> rest) throw parseError(lineNumber, "trailing \"" + rest + "\"");
+    }
+    return hasAnything;
+}
+
+bool readProblem(std::istream& input, LinearProgrammingProblem& problem) {
+    int lineNumber = 0;
+    return readProblem(input, problem, lineNumber);
+}
+
+void writeProblem(std::ostream& output, LinearProgrammingProblem& problem) {
+    // Enough digits for a float to survive the round trip
+    std::streamsize precision = output.precision(9);
+    const glm::vec4& objective = problem.objectiveFunction;
+    output << (problem.doMinimize ? "minimize " : "maximize ")
+           << objective.x << ' ' << objective.y << ' ' << objective.z << ' ' << objective.w << '\n';
+    for (int planeIndex = 0; planeIndex < problem.getEquationCount(); planeIndex++) {
+        auto plane = problem.getLimitPlane(planeIndex);
+        const glm::vec4& coefficients = plane.equationCoefficients;
+        output << coefficients.x << ' ' << coefficients.y << ' ' << coefficients.z << ' '
+               << equationSigns[plane.type] << ' ' << coefficients.w << '\n';
+    }
+    output.precision(precision);
+}
@@ -0,0 +1,187 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+#include <glad/glad.h>
+#include <imgui/imgui.h>
+
+namespace {
+const char* const sectionNames[PROFILE_SECTION_COUNT] = {
+    "ImGui build",
+    "World grid",
+    "Limit planes",
+    "Solution",
+    "ImGui render"
+};
+
+float sinceMilliseconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+const float NO_SAMPLE = std::numeric_limits<float>::quiet_NaN();
+
+float getAverage(const float* history) {
+    float total = 0;
+    int count = 0;
+    for (int slot = 0; slot < FrameProfiler::HISTORY_SIZE; slot++) {
+        if (std::isnan(history[slot])) continue;
+        total += history[slot];
+        count++;
+    }
+    return count > 0 ? total / count : 0;
+}
+
+// Samples that are there, oldest first. Plotting the missing ones would draw them as dips
+int getSamples(const float* history, int oldest, float* samples) {
+    int count = 0;
+    for (int offset = 0; offset < FrameProfiler::HISTORY_SIZE; offset++) {
+        float sample = history[(oldest + offset) % FrameProfiler::HISTORY_SIZE];
+        if (!std::isnan(sample)) samples[count++] = sample;
+    }
+    return count;
+}
+
+void plotSamples(const char* label, const float* history, int oldest, const char* overlay, ImVec2 size) {
+    float samples[FrameProfiler::HISTORY_SIZE];
+    int count = getSamples(history, oldest, samples);
+    ImGui::PlotLines(label, samples, count, 0, overlay, 0.0f, FLT_MAX, size);
+}
+} // namespace
+
+FrameProfiler::FrameProfiler() {
+    std::fill(std::begin(this->frameMilliseconds), std::end(this->frameMilliseconds), NO_SAMPLE);
+    for (Section& section : this->sections) {
+        std::fill(std::begin(section.cpuMilliseconds), std::end(section.cpuMilliseconds), NO_SAMPLE);
+        std::fill(std::begin(section.gpuMilliseconds), std::end(section.gpuMilliseconds), NO_SAMPLE);
+    }
+}
+
+/**
+ * Picks up whatever's ready by now, from any set, back into the frame that issued it.
+ * The set about to be reused (querySet, already moved along) is out of time: if it's still
+ * not done, it's dropped and that frame keeps its NaN.
+ */
+void FrameProfiler::collectQueries() {
+    for (Section& section : this->sections) {
+        for (int set = 0; set < QUERY_SET_COUNT; set++) {
+            if (!section.isQueryIssued[set]) continue;
+            GLint isAvailable = GL_FALSE;
+            glGetQueryObjectiv(section.queries[set], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+            if (isAvailable != GL_TRUE) {
+                if (set == this->querySet) section.isQueryIssued[set] = false;
+                continue;
+            }
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(section.queries[set], GL_QUERY_RESULT, &elapsed);
+            section.gpuMilliseconds[section.issuedSlot[set]] = elapsed / 1e6f;
+            section.isQueryIssued[set] = false;
+        }
+    }
+}
+
+void FrameProfiler::newFrame() {
+    if (!this->isEnabled) return;
+    if (!this->hasQueries) {
+        for (Section& section : this->sections) glGenQueries(QUERY_SET_COUNT, section.queries);
+        this->hasQueries = true;
+    }
+
+    this->historyOffset = (this->historyOffset + 1) % HISTORY_SIZE;
+    this->querySet = (this->querySet + 1) % QUERY_SET_COUNT;
+    this->collectQueries();
+    // Stays NaN for anything that doesn't run this frame, or doesn't get its GPU time back
+    this->frameMilliseconds[this->historyOffset] = NO_SAMPLE;
+    for (Section& section : this->sections) {
+        section.cpuMilliseconds[this->historyOffset] = NO_SAMPLE;
+        section.gpuMilliseconds[this->historyOffset] = NO_SAMPLE;
+    }
+    this->frameStartedAt = Clock::now();
+}
+
+void FrameProfiler::endFrame() {
+    if (!this->isEnabled || !this->hasQueries) return;
+    this->frameMilliseconds[this->historyOffset] = sinceMilliseconds(this->frameStartedAt);
+}
+
+void FrameProfiler::begin(ProfileSection section) {
+    if (!this->isEnabled || !this->hasQueries || this->activeSection >= 0) return;
+    this->activeSection = section;
+    Section& timed = this->sections[section];
+    timed.startedAt = Clock::now();
+    glBeginQuery(GL_TIME_ELAPSED, timed.queries[this->querySet]);
+}
+
+void FrameProfiler::end(ProfileSection section) {
+    if (this->activeSection != section) return;
+    Section& timed = this->sections[section];
+    glEndQuery(GL_TIME_ELAPSED);
+    timed.isQueryIssued[this->querySet] = true;
+    timed.issuedSlot[this->querySet] = this->historyOffset;
+    timed.cpuMilliseconds[this->historyOffset] = sinceMilliseconds(timed.startedAt);
+    this->activeSection = -1;
+}
+
+float FrameProfiler::getAverageCPU(ProfileSection section) const {
+    return getAverage(this->sections[section].cpuMilliseconds);
+}
+
+float FrameProfiler::getAverageGPU(ProfileSection section) const {
+    return getAverage(this->sections[section].gpuMilliseconds);
+}
+
+float FrameProfiler::getAverageFrame() const {
+    return getAverage(this->frameMilliseconds);
+}
+
+const char* FrameProfiler::getSectionName(ProfileSection section) {
+    return sectionNames[section];
+}
+
+void FrameProfiler::draw(bool* isOpen) {
+    if (!ImGui::Begin("Frame profiler", isOpen)) {
+        ImGui::End();
+        return;
+    }
+    int oldest = (this->historyOffset + 1) % HISTORY_SIZE;
+    const ImVec2 graphSize = ImVec2(ImGui::GetContentRegionAvail().x, 40);
+
+    ImGui::Text("Frame: %.3f ms", this->getAverageFrame());
+    plotSamples("##frame", this->frameMilliseconds, oldest, nullptr, graphSize);
+
+    for (int section = 0; section < PROFILE_SECTION_COUNT; section++) {
+        ImGui::PushID(section);
+        ImGui::Separator();
+        ImGui::Text("%s: CPU %.3f ms, GPU %.3f ms", getSectionName(static_cast<ProfileSection>(section)),
+            this->getAverageCPU(static_cast<ProfileSection>(section)),
+            this->getAverageGPU(static_cast<ProfileSection>(section)));
+        plotSamples("##cpu", this->sections[section].cpuMilliseconds, oldest, "CPU", graphSize);
+        plotSamples("##gpu", this->sections[section].gpuMilliseconds, oldest, "GPU", graphSize);
+        ImGui::PopID();
+    }
+    ImGui::End();
+}
+
+void FrameProfiler::release() {
+    if (!this->hasQueries) return;
+    if (this->activeSection >= 0) glEndQuery(GL_TIME_ELAPSED);
+    for (Section& section : this->sections) {
+        glDeleteQueries(QUERY_SET_COUNT, section.queries);
+        std::fill(std::begin(section.isQueryIssued), std::end(section.isQueryIssued), false);
+    }
+    this->activeSection = -1;
+    this->hasQueries = false;
+}
+
+FrameProfiler::~FrameProfiler() { this->release(); }
+
+ProfileScope::ProfileScope(FrameProfiler* profiler, ProfileSection section) {
+    this->profiler = profiler;
+    this->section = section;
+    if (this->profiler) this->profiler->begin(section);
+}
+
+ProfileScope::~ProfileScope() { if (this->profiler) this->profiler->end(this->section); }
@@ -0,0 +1,133 @@
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "solver.h"
+#include "seidel.h"
+#include "workpool.h"
+
+namespace {
+
+// Relative to the row's own scale and how far out the region is, same idea as Seidel's tolerances
+const double REDUNDANCY_EPSILON = 1e-7;
+// What a row turns into while it's being left out, 0 <= 1 holds everywhere
+const glm::dvec4 NO_ROW = glm::dvec4(0, 0, 0, 1);
+
+double getTolerance(const glm::dvec4& halfspace, const glm::dvec3& point) {
+    return REDUNDANCY_EPSILON * (1 + std::abs(halfspace.w) + glm::length(glm::dvec3(halfspace)) * glm::length(point));
+}
+
+enum Reach {
+    REACH_INSIDE,   // Never gets to the row, not even touching it
+    REACH_TOUCHING, // Gets right up to it
+    REACH_BEYOND,
+    REACH_UNKNOWN
+};
+
+// How far the halfspace's own direction gets over the others, the halfspace itself should be NO_ROW by now
+Reach getReach(const std::vector<glm::dvec4>& others, const glm::dvec4& halfspace) {
+    glm::dvec3 direction = glm::dvec3(halfspace);
+    SeidelResult result = seidelMaximize(others, direction);
+    switch (result.status) {
+        case SEIDEL_UNBOUNDED: return REACH_BEYOND;
+        case SEIDEL_OPTIMAL: break;
+        default: return REACH_UNKNOWN; // Seidel isn't sure, or the rest is infeasible on its own and there's no region anyway
+    }
+    double reach = glm::dot(direction, result.point);
+    double tolerance = getTolerance(halfspace, result.point);
+    if (reach < halfspace.w - tolerance) return REACH_INSIDE;
+    return reach <= halfspace.w + tolerance ? REACH_TOUCHING : REACH_BEYOND;
+}
+
+} // namespace
+
+/**
+ * The Seidel half of classifyConstraints(), one plane per work item. A plane is redundant
+ * when its own direction can't get past it with the plane taken out. If the region
+ * is flat (no Chebyshev ball fits), an inequality that can't get off its plane from the inside
+ * either is an implicit equality. Anything Seidel shrugs at comes back CONSTRAINT_UNKNOWN.
+ * isDroppingOnly is for presolve: only rows that don't even touch the region count as redundant,
+ * those can all go at once, and there's no looking for implicit equalities.
+ */
+std::vector<ConstraintClass> LinearProgrammingProblem::classifyRows(const std::vector<Equation>& planeEquations, int threadCount, bool isDroppingOnly) {
+    std::vector<ConstraintClass> classes(planeEquations.size(), ConstraintClass::CONSTRAINT_UNKNOWN);
+    if (planeEquations.empty()) return classes;
+    const std::vector<glm::dvec4> halfspaces = getHalfspaces(planeEquations);
+    // getHalfspaces() gives equalities two, so keep count of where each plane's ones start
+    std::vector<uint32_t> firstHalfspaces(planeEquations.size());
+    uint32_t halfspaceCount = 0;
+    for (size_t plane = 0; plane < planeEquations.size(); plane++) {
+        firstHalfspaces[plane] = halfspaceCount;
+        halfspaceCount += planeEquations[plane].type == EquationType::EQUAL_TO ? 2 : 1;
+    }
+
+    bool isFlat = false;
+    if (!isDroppingOnly) {
+        SeidelResult center = seidelChebyshevCenter(halfspaces);
+        if (center.status == SEIDEL_INFEASIBLE) return classes; // Nothing to hold up
+        isFlat = center.status == SEIDEL_DEGENERATE
+              || (center.status == SEIDEL_OPTIMAL && center.value <= REDUNDANCY_EPSILON * (1 + glm::length(center.point)));
+    }
+
+    const uint32_t planeCount = static_cast<uint32_t>(planeEquations.size());
+    threadCount = getWorkerCount(planeCount, threadCount);
+    // Each thread blanks out rows in its own copy
+    std::vector<std::vector<glm::dvec4>> scratch(threadCount, halfspaces);
+    forEachStealing(planeCount, threadCount, [&](int worker, uint32_t plane) {
+        std::vector<glm::dvec4>& others = scratch[worker];
+        const uint32_t first = firstHalfspaces[plane];
+        ConstraintClass& result = classes[plane];
+
+        if (planeEquations[plane].type == EquationType::EQUAL_TO) {
+            // Has to be out of both directions' way, and then it's touching by definition
+            others[first] = others[first + 1] = NO_ROW;
+            Reach up = getReach(others, halfspaces[first]);
+            Reach down = up == REACH_UNKNOWN ? REACH_UNKNOWN : getReach(others, halfspaces[first + 1]);
+            others[first] = halfspaces[first];
+            others[first + 1] = halfspaces[first + 1];
+            if (up == REACH_UNKNOWN || down == REACH_UNKNOWN) return;
+            bool isRedundant = up != REACH_BEYOND && down != REACH_BEYOND;
+            result = isRedundant && !isDroppingOnly ? CONSTRAINT_REDUNDANT : CONSTRAINT_BINDING;
+            return;
+        }
+
+        others[first] = NO_ROW;
+        Reach reach = getReach(others, halfspaces[first]);
+        others[first] = halfspaces[first];
+        if (reach == REACH_UNKNOWN) return;
+        if (reach == REACH_INSIDE || (reach == REACH_TOUCHING && !isDroppingOnly)) {
+            result = CONSTRAINT_REDUNDANT;
+            return;
+        }
+        result = CONSTRAINT_BINDING;
+        if (!isFlat) return;
+
+        // Flat region: see if anything in it gets off the plane, going the other way
+        SeidelResult lowest = seidelMaximize(others, -glm::dvec3(halfspaces[first]));
+        if (lowest.status == SEIDEL_UNBOUNDED) return;
+        if (lowest.status != SEIDEL_OPTIMAL) {
+            result = CONSTRAINT_UNKNOWN;
+            return;
+        }
+        double low = glm::dot(glm::dvec3(halfspaces[first]), lowest.point);
+        if (low >= halfspaces[first].w - getTolerance(halfspaces[first], lowest.point)) result = CONSTRAINT_IMPLICIT_EQUALITY;
+    });
+    return classes;
+}
+
+std::vector<ConstraintClass> LinearProgrammingProblem::classifyConstraints(int threadCount) const {
+    std::vector<ConstraintClass> classes = classifyRows(this->planeEquations, threadCount, false);
+    classifyWithCddlib(this->planeEquations, classes); // Nothing to ask without cddlib, unknowns stay unknown
+    return classes;
+}
+
+std::future<std::vector<ConstraintClass>> LinearProgrammingProblem::classifyConstraintsAsync(int threadCount) const {
+    return std::async(std::launch::async, [](std::vector<Equation> planeEquations, int threadCount) {
+        std::vector<ConstraintClass> classes = classifyRows(planeEquations, threadCount, false);
+        classifyWithCddlib(planeEquations, classes);
+        return classes;
+    }, this->planeEquations, threadCount);
+}
@@ -0,0 +1,354 @@
+#include "seidel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+// The whole thing runs inside of this box, so there's always a vertex to stand on.
+// Ending up on its walls means either unbounded or something awkward.
+const double BOX_SIZE = 1e9;
+const double ZERO_EPSILON = 1e-12;
+const double FEASIBILITY_EPSILON = 1e-9;
+// For the final check against the input, after all the substitutions had their say
+const double VERIFY_EPSILON = 1e-6;
+
+// Up to 4 columns, the Chebyshev center needs one for the radius
+const int MAX_DIMENSION = 4;
+
+struct Row {
+    double a[MAX_DIMENSION];
+    double b;
+};
+
+/**
+ * Row storage, kept per thread so back to back solves (batches, one LP per plane) reuse
+ * whatever they grew to last time instead of allocating. Nothing here calls back out,
+ * so one solve at a time per thread is all there is.
+ */
+struct Scratch {
+    std::vector<Row> rows;
+    std::vector<Row> objectives;
+    std::vector<Row> directionRows;
+    // One level of the recursion each, by the dimension it goes down to
+    std::vector<Row> reducedRows[MAX_DIMENSION];
+    std::vector<Row> reducedObjectives[MAX_DIMENSION];
+};
+
+Scratch& getScratch() {
+    static thread_local Scratch scratch;
+    return scratch;
+}
+
+double rowSlack(const Row& row, const double* point, int dimension) {
+    double value = -row.b;
+    for (int axis = 0; axis < dimension; axis++) value += row.a[axis] * point[axis];
+    return value;
+}
+
+double rowTolerance(const Row& row, const double* point, int dimension, double epsilon) {
+    double scale = 1 + std::abs(row.b);
+    for (int axis = 0; axis < dimension; axis++) scale += std::abs(row.a[axis] * point[axis]);
+    return epsilon * scale;
+}
+
+// Keeps the largest coefficient at 1, so the epsilons mean roughly the same thing at every depth
+void normalizeRow(Row& row, int dimension) {
+    double scale = 0;
+    for (int axis = 0; axis < dimension; axis++) scale = std::max(scale, std::abs(row.a[axis]));
+    if (scale <= ZERO_EPSILON) return;
+    for (int axis = 0; axis < dimension; axis++) row.a[axis] /= scale;
+    row.b /= scale;
+}
+
+/**
+ * Box rows go first, two per axis: +x_i <= size, then -x_i <= size.
+ * The recursion relies on that order to find them again.
+ */
+void appendBox(std::vector<Row>& rows, int dimension, double size) {
+    for (int axis = 0; axis < dimension; axis++) {
+        Row upper = {{0, 0, 0, 0}, size};
+        Row lower = {{0, 0, 0, 0}, size};
+        upper.a[axis] = 1;
+        lower.a[axis] = -1;
+        rows.push_back(upper);
+        rows.push_back(lower);
+    }
+}
+
+/**
+ * Objectives are compared lexicographically: the first one that cares about an axis decides it.
+ * Over a box that's separable, so it's just picking walls.
+ */
+void boxOptimum(const std::vector<Row>& objectives, int dimension, double size, double* point) {
+    for (int axis = 0; axis < dimension; axis++) {
+        point[axis] = -size;
+        for (const Row& objective : objectives) {
+            if (std::abs(objective.a[axis]) <= ZERO_EPSILON) continue;
+            point[axis] = objective.a[axis] > 0 ? size : -size;
+            break;
+        }
+    }
+}
+
+// Drops `axis` from `row` by plugging in x_axis from plane's equality
+Row substituteRow(const Row& row, const Row& plane, int axis, int dimension) {
+    Row reduced = {{0, 0, 0, 0}, 0};
+    double factor = row.a[axis] / plane.a[axis];
+    int column = 0;
+    for (int other = 0; other < dimension; other++) {
+        if (other == axis) continue;
+        reduced.a[column++] = row.a[other] - factor * plane.a[other];
+    }
+    reduced.b = row.b - factor * plane.b;
+    return reduced;
+}
+
+SeidelStatus solveLine(const std::vector<Row>& rows, const std::vector<Row>& objectives, double* point, bool& degenerate) {
+    double lower = -std::numeric_limits<double>::infinity();
+    double upper = std::numeric_limits<double>::infinity();
+    for (const Row& row : rows) {
+        if (std::abs(row.a[0]) <= ZERO_EPSILON) {
+            // 0 <= b, parallel to the line
+            if (row.b < -VERIFY_EPSILON) return SEIDEL_INFEASIBLE;
+            if (row.b < -FEASIBILITY_EPSILON) degenerate = true;
+            continue;
+        }
+        double bound = row.b / row.a[0];
+        if (row.a[0] > 0) upper = std::min(upper, bound);
+        else lower = std::max(lower, bound);
+    }
+    // Equalities land here as two rows agreeing on a single point, give them some slack
+    if (lower - upper > FEASIBILITY_EPSILON * (1 + std::abs(lower) + std::abs(upper))) return SEIDEL_INFEASIBLE;
+    if (lower > upper) upper = lower;
+
+    point[0] = lower;
+    for (const Row& objective : objectives) {
+        if (std::abs(objective.a[0]) <= ZERO_EPSILON) continue;
+        point[0] = objective.a[0] > 0 ? upper : lower;
+        break;
+    }
+    return SEIDEL_OPTIMAL;
+}
+
+SeidelStatus solveReduced(const std::vector<Row>& rows, const std::vector<Row>& objectives, int dimension, double boxSize, double* point, bool& degenerate) {
+    if (dimension == 1) return solveLine(rows, objectives, point, degenerate);
+
+    boxOptimum(objectives, dimension, boxSize, point);
+    for (size_t current = 2 * dimension; current < rows.size(); current++) {
+        const Row& plane = rows[current];
+        if (rowSlack(plane, point, dimension) <= rowTolerance(plane, point, dimension, FEASIBILITY_EPSILON)) continue;
+
+        // Optimum moved onto this plane now, so get rid of its steepest axis and go one dimension down
+        int axis = 0;
+        for (int other = 1; other < dimension; other++) {
+            if (std::abs(plane.a[other]) > std::abs(plane.a[axis])) axis = other;
+        }
+        if (std::abs(plane.a[axis]) <= ZERO_EPSILON) {
+            if (plane.b > -VERIFY_EPSILON) degenerate = true;
+            return SEIDEL_INFEASIBLE;
+        }
+
+        std::vector<Row>& reducedRows = getScratch().reducedRows[dimension - 1];
+        reducedRows.clear();
+        // Box walls of the axes we keep stay box walls, and have to stay up front
+        for (int other = 0; other < dimension; other++) {
+            if (other == axis) continue;
+            reducedRows.push_back(substituteRow(rows[2 * other], plane, axis, dimension));
+            reducedRows.push_back(substituteRow(rows[2 * other + 1], plane, axis, dimension));
+        }
+        reducedRows.push_back(substituteRow(rows[2 * axis], plane, axis, dimension));
+        reducedRows.push_back(substituteRow(rows[2 * axis + 1], plane, axis, dimension));
+        for (size_t previous = 2 * dimension; previous < current; previous++) {
+            reducedRows.push_back(substituteRow(rows[previous], plane, axis, dimension));
+        }
+        for (size_t row = 2 * (dimension - 1); row < reducedRows.size(); row++) {
+            normalizeRow(reducedRows[row], dimension - 1);
+        }
+
+        std::vector<Row>& reducedObjectives = getScratch().reducedObjectives[dimension - 1];
+        reducedObjectives.clear();
+        for (const Row& objective : objectives) {
+            reducedObjectives.push_back(substituteRow(objective, plane, axis, dimension));
+        }
+
+        double reducedPoint[MAX_DIMENSION] = {0, 0, 0, 0};
+        SeidelStatus status = solveReduced(reducedRows, reducedObjectives, dimension - 1, boxSize, reducedPoint, degenerate);
+        if (status != SEIDEL_OPTIMAL) return status;
+
+        double sum = 0;
+        int column = 0;
+        for (int other = 0; other < dimension; other++) {
+            if (other == axis) continue;
+            point[other] = reducedPoint[column++];
+            sum += plane.a[other] * point[other];
+        }
+        point[axis] = (plane.b - sum) / plane.a[axis];
+    }
+    return SEIDEL_OPTIMAL;
+}
+
+} // namespace
+
+SeidelResult seidelMaximize(const std::vector<glm::dvec4>& halfspaces, glm::dvec3 objective) {
+    SeidelResult result;
+
+    // Only solve for the axes somebody actually constrains, the rest stay at 0.
+    // Without that a 2D problem would go hunting for z at the box walls.
+    int axes[3];
+    int dimension = 0;
+    bool isOpenAxis = false;
+    for (int axis = 0; axis < 3; axis++) {
+        bool isUsed = false;
+        for (const glm::dvec4& halfspace : halfspaces) {
+            if (halfspace[axis] != 0) { isUsed = true; break; }
+        }
+        if (isUsed) axes[dimension++] = axis;
+        else if (objective[axis] != 0) isOpenAxis = true;
+    }
+
+    Scratch& scratch = getScratch();
+    std::vector<Row>& rows = scratch.rows;
+    rows.clear();
+    appendBox(rows, dimension, BOX_SIZE);
+    for (const glm::dvec4& halfspace : halfspaces) {
+        Row row = {{0, 0, 0, 0}, halfspace.w};
+        for (int axis = 0; axis < dimension; axis++) row.a[axis] = halfspace[axes[axis]];
+        normalizeRow(row, dimension);
+        rows.push_back(row);
+    }
+
+    // The "randomized" part, which buys the expected linear time.
+    // Fixed seed, so the same system always walks the same way
+    static thread_local std::minstd_rand shuffler;
+    shuffler.seed(1);
+    std::shuffle(rows.begin() + 2 * dimension, rows.end(), shuffler);
+
+    // Actual objective first, then the tie breakers
+    std::vector<Row>& objectives = scratch.objectives;
+    objectives.clear();
+    Row mainObjective = {{0, 0, 0, 0}, 0};
+    for (int axis = 0; axis < dimension; axis++) mainObjective.a[axis] = objective[axes[axis]];
+    objectives.push_back(mainObjective);
+    for (int axis = 0; axis < dimension; axis++) {
+        Row tieBreaker = {{0, 0, 0, 0}, 0};
+        tieBreaker.a[axis] = -1;
+        objectives.push_back(tieBreaker);
+    }
+
+    double point[MAX_DIMENSION] = {0, 0, 0, 0};
+    bool degenerate = false;
+    if (dimension == 0) {
+        // Every row is 0 <= b, nothing to solve but a sanity check
+        for (const Row& row : rows) {
+            if (row.b < -FEASIBILITY_EPSILON) {
+                result.status = row.b < -VERIFY_EPSILON ? SEIDEL_INFEASIBLE : SEIDEL_DEGENERATE;
+                return result;
+            }
+        }
+    } else {
+        SeidelStatus status = solveReduced(rows, objectives, dimension, BOX_SIZE, point, degenerate);
+        if (status == SEIDEL_INFEASIBLE) {
+            result.status = degenerate ? SEIDEL_DEGENERATE : SEIDEL_INFEASIBLE;
+            return result;
+        }
+    }
+
+    for (int axis = 0; axis < dimension; axis++) result.point[axes[axis]] = point[axis];
+    if (isOpenAxis) {
+        result.status = SEIDEL_UNBOUNDED;
+        return result;
+    }
+
+    // Substitutions pile up rounding errors, so check the answer against what we were given
+    for (const glm::dvec4& halfspace : halfspaces) {
+        double slack = glm::dot(glm::dvec3(halfspace), result.point) - halfspace.w;
+        double scale = 1 + std::abs(halfspace.w) + std::abs(halfspace.x * result.point.x) + std::abs(halfspace.y * result.point.y) + std::abs(halfspace.z * result.point.z);
+        if (slack > VERIFY_EPSILON * scale) degenerate = true;
+    }
+    if (degenerate) {
+        result.status = SEIDEL_DEGENERATE;
+        return result;
+    }
+
+    bool isOnBox = false;
+    for (int axis = 0; axis < dimension; axis++) {
+        if (std::abs(point[axis]) >= BOX_SIZE * (1 - FEASIBILITY_EPSILON)) isOnBox = true;
+    }
+    if (!isOnBox) {
+        result.status = SEIDEL_OPTIMAL;
+        return result;
+    }
+
+    /**
+     * Hit a wall, so either the objective really runs off to infinity, or only the tie breakers do.
+     * Ask the same question about directions: max objective·r over A·r <= 0 inside a unit box.
+     * Anything positive is a ray we can ride forever.
+     */
+    std::vector<Row>& directionRows = scratch.directionRows;
+    directionRows.clear();
+    appendBox(directionRows, dimension, 1);
+    for (size_t row = 2 * dimension; row < rows.size(); row++) {
+        Row direction = rows[row];
+        direction.b = 0;
+        directionRows.push_back(direction);
+    }
+    double direction[MAX_DIMENSION] = {0, 0, 0, 0};
+    solveReduced(directionRows, objectives, dimension, 1, direction, degenerate);
+    double improvement = 0;
+    for (int axis = 0; axis < dimension; axis++) improvement += mainObjective.a[axis] * direction[axis];
+    // Bounded, but the optimal face runs off somewhere. cddlib will pick a nicer point off it
+    result.status = improvement > FEASIBILITY_EPSILON * glm::length(objective) ? SEIDEL_UNBOUNDED : SEIDEL_DEGENERATE;
+    return result;
+}
+
+SeidelResult seidelChebyshevCenter(const std::vector<glm::dvec4>& halfspaces) {
+    SeidelResult result;
+
+    // Same LP as always, just with the radius as the fourth column:
+    // max r over A·x + |A|·r <= B
+    const int dimension = 4;
+    Scratch& scratch = getScratch();
+    std::vector<Row>& rows = scratch.rows;
+    rows.clear();
+    appendBox(rows, dimension, BOX_SIZE);
+    for (const glm::dvec4& halfspace : halfspaces) {
+        glm::dvec3 normal = glm::dvec3(halfspace);
+        Row row = {{normal.x, normal.y, normal.z, glm::length(normal)}, halfspace.w};
+        normalizeRow(row, dimension);
+        rows.push_back(row);
+    }
+
+    static thread_local std::minstd_rand shuffler;
+    shuffler.seed(1);
+    std::shuffle(rows.begin() + 2 * dimension, rows.end(), shuffler);
+
+    std::vector<Row>& objectives = scratch.objectives;
+    objectives.clear();
+    objectives.push_back(Row{{0, 0, 0, 1}, 0});
+    for (int axis = 0; axis < 3; axis++) {
+        Row tieBreaker = {{0, 0, 0, 0}, 0};
+        tieBreaker.a[axis] = -1;
+        objectives.push_back(tieBreaker);
+    }
+
+    double point[MAX_DIMENSION] = {0, 0, 0, 0};
+    bool degenerate = false;
+    SeidelStatus status = solveReduced(rows, objectives, dimension, BOX_SIZE, point, degenerate);
+    result.point = glm::dvec3(point[0], point[1], point[2]);
+    result.value = point[3];
+    if (status == SEIDEL_INFEASIBLE) {
+        result.status = degenerate ? SEIDEL_DEGENERATE : SEIDEL_INFEASIBLE;
+        return result;
+    }
+
+    // Walls of the box mean the region runs off somewhere, and there's no center to speak of
+    result.status = degenerate ? SEIDEL_DEGENERATE : SEIDEL_OPTIMAL;
+    for (int axis = 0; axis < dimension; axis++) {
+        if (std::abs(point[axis]) >= BOX_SIZE * (1 - FEASIBILITY_EPSILON)) result.status = SEIDEL_UNBOUNDED;
+    }
+    return result;
+}
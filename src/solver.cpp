@@ -1,16 +1,30 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <list>
 #include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
 #include <vector>
 
-#include "assets.h"
-#include "camera.h"
-#include "glm/glm.hpp"
+#include <glm/glm.hpp>
+
 #include "solver.h"
+#include "seidel.h"
+#include "halfspace.h"
 #include "config.h"
 
 #ifdef USE_CDDLIB
 #define REFLECT(var) #var
 #include <cdd/setoper.h>
 #include <cdd/cdd.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 #include <quickhull/QuickHull.hpp>
 #endif
@@ -72,84 +86,438 @@ glm::vec3 createVector(dd_Arow dd_vector, int vector_length) {
     return vector;
 }
 
-std::vector<float> getVertices(dd_MatrixPtr vform) {
-    std::vector<float> vertices;
+// Rows with a one in front are vertices, the rest are rays (or lines)
+size_t countVertices(dd_MatrixPtr vform) {
+    size_t vertexCount = 0;
+    for (int row = 0; row < vform->rowsize; row++) {
+        if (vform->matrix[row][0][0] != 0) vertexCount++;
+    }
+    return vertexCount;
+}
+
+void getVertices(dd_MatrixPtr vform, std::vector<float>& vertices) {
+    vertices.resize(countVertices(vform) * 3);
+    size_t vertex = 0;
     for (int row = 0; row < vform->rowsize; row++) {
         if (vform->matrix[row][0][0] == 0) continue;
-        vertices.push_back(vform->matrix[row][1][0]);
-        vertices.push_back(vform->matrix[row][2][0]);
-        vertices.push_back(vform->matrix[row][3][0]);
+        vertices[vertex++] = vform->matrix[row][1][0];
+        vertices[vertex++] = vform->matrix[row][2][0];
+        vertices[vertex++] = vform->matrix[row][3][0];
     }
-    return vertices;
 }
 
-std::vector<std::vector<int>> getAdjacency(dd_SetFamilyPtr adj) {
-    std::vector<std::vector<int>> adjacency;
-    for (int vertex = 0; vertex < adj->famsize; vertex++) {
-        std::vector<int> vertex_adjacent;
+// Lines (from linset) go both ways, so they're put in twice
+void getRays(dd_MatrixPtr vform, std::vector<float>& rays) {
+    rays.clear();
+    rays.reserve((vform->rowsize - countVertices(vform)) * 6);
+    for (int row = 0; row < vform->rowsize; row++) {
+        if (vform->matrix[row][0][0] != 0) continue;
+        glm::vec3 ray = createVector(vform->matrix[row], vform->colsize);
+        rays.push_back(ray.x); rays.push_back(ray.y); rays.push_back(ray.z);
+        if (set_member(row + 1, vform->linset)) {
+            rays.push_back(-ray.x); rays.push_back(-ray.y); rays.push_back(-ray.z);
+        }
+    }
+}
+
+// cddlib's sets are arrays of unsigned long: the size up front, then the members packed
+// from the lowest bit, element 1 first. Those are 32 bits on MSVC and 64 pretty much everywhere else.
+const long SET_WORD_BITS = sizeof(unsigned long) * CHAR_BIT;
+
+inline int countTrailingZeroes(unsigned long word) {
+    #ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, word);
+    return index;
+    #else
+    return __builtin_ctzl(word);
+    #endif
+}
+
+inline int countBits(unsigned long word) {
+    #ifdef _MSC_VER
+    return __popcnt(word);
+    #else
+    return __builtin_popcountl(word);
+    #endif
+}
+
+// Which generators are vertices, as a set-shaped mask, and where each one ended up in getVertices()
+struct VertexRows {
+    std::vector<unsigned long> mask;
+    std::vector<uint32_t> index; // UINT32_MAX for rays
+    uint32_t count = 0;
+};
 
-		long cardinality = set_card(adj->set[vertex]);
-		// bool invert = adj->setsize - cardinality >= cardinality;
+VertexRows getVertexRows(dd_MatrixPtr vform, long setSize) {
+    VertexRows rows;
+    rows.mask.assign((setSize + SET_WORD_BITS - 1) / SET_WORD_BITS, 0);
+    rows.index.assign(vform->rowsize, UINT32_MAX);
+    for (long row = 0; row < vform->rowsize; row++) {
+        if (vform->matrix[row][0][0] == 0) continue;
+        rows.index[row] = rows.count++;
+        if (row < setSize) rows.mask[row / SET_WORD_BITS] |= 1ul << (row % SET_WORD_BITS);
+    }
+    return rows;
+}
+
+/**
+ * cddlib's adjacency is over all generators, rays included, counted from 1.
+ * Only vertex-to-vertex edges make it in here, renumbered to match getVertices().
+ * Goes a word at a time: each row gets ANDed with a mask of vertex rows, which drops the rays,
+ * then popcounts size the CSR arrays exactly and ctz walks straight to the set bits.
+ */
+void getAdjacency(dd_SetFamilyPtr adj, dd_MatrixPtr vform, Adjacency& adjacency) {
+    const long rowCount = std::min<long>(adj->famsize, vform->rowsize);
+    const long wordCount = (adj->setsize + SET_WORD_BITS - 1) / SET_WORD_BITS;
+    VertexRows vertexRows = getVertexRows(vform, adj->setsize);
+    const std::vector<unsigned long>& vertexMask = vertexRows.mask;
+    const std::vector<uint32_t>& vertexIndex = vertexRows.index;
+    const uint32_t vertexCount = vertexRows.count;
+
+    // First pass counts, so the second one writes straight into place
+    adjacency.offsets.assign(vertexCount + 1, 0);
+    for (long row = 0; row < rowCount; row++) {
+        if (vertexIndex[row] == UINT32_MAX) continue;
+        const unsigned long* words = adj->set[row] + 1;
+        long cardinality = 0;
+        uint32_t neighbourCount = 0;
+        for (long word = 0; word < wordCount; word++) {
+            cardinality += countBits(words[word]);
+            neighbourCount += countBits(words[word] & vertexMask[word]);
+        }
+        // Adjacent to every single generator is cddlib's way of saying nothing useful
         if (cardinality == adj->famsize) continue;
-		for (int elemt = 1; elemt <= adj->set[vertex][0]; elemt++) {
-			if (set_member(elemt, adj->set[vertex]))
-				vertex_adjacent.push_back(elemt);
-		}
+        adjacency.offsets[vertexIndex[row] + 1] = neighbourCount;
+    }
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++) adjacency.offsets[vertex + 1] += adjacency.offsets[vertex];
 
-        // XXX: May cause some issues, if an empty row will show up first.
-        if (!vertex_adjacent.empty())
-            adjacency.push_back(vertex_adjacent);
+    adjacency.neighbours.resize(adjacency.offsets[vertexCount]);
+    for (long row = 0; row < rowCount; row++) {
+        if (vertexIndex[row] == UINT32_MAX) continue;
+        uint32_t* neighbour = adjacency.neighbours.data() + adjacency.offsets[vertexIndex[row]];
+        const uint32_t* end = adjacency.neighbours.data() + adjacency.offsets[vertexIndex[row] + 1];
+        const unsigned long* words = adj->set[row] + 1;
+        for (long word = 0; word < wordCount && neighbour != end; word++) {
+            unsigned long bits = words[word] & vertexMask[word];
+            while (bits != 0) {
+                *neighbour++ = vertexIndex[word * SET_WORD_BITS + countTrailingZeroes(bits)];
+                bits &= bits - 1; // Lowest one's done
+            }
+        }
+    }
+}
+
+/**
+ * Input incidence goes the other way: one set per input row, listing the generators lying on it.
+ * Rows past the problem's own (cddlib's homogenizing one) are skipped, rays are masked out
+ * the same way getAdjacency() does it, and buildFacets() takes care of the rest.
+ * normals are the outward ones, one per input row.
+ */
+void getFacets(dd_SetFamilyPtr inc, dd_MatrixPtr vform, const std::vector<glm::dvec3>& normals, const std::vector<float>& vertices, FacetIncidence& facets) {
+    const long rowCount = std::min<long>(inc->famsize, normals.size());
+    const long wordCount = (inc->setsize + SET_WORD_BITS - 1) / SET_WORD_BITS;
+    VertexRows vertexRows = getVertexRows(vform, inc->setsize);
+
+    facets.clear();
+    for (long row = 0; row < rowCount; row++) {
+        uint32_t vertexCount = 0;
+        for (long word = 0; word < wordCount; word++) vertexCount += countBits(inc->set[row][word + 1] & vertexRows.mask[word]);
+        if (vertexCount < 3) continue;
+        facets.offsets.push_back(facets.vertices.size());
+        facets.planes.push_back(row);
+        for (long word = 0; word < wordCount; word++) {
+            unsigned long bits = inc->set[row][word + 1] & vertexRows.mask[word];
+            while (bits != 0) {
+                facets.vertices.push_back(vertexRows.index[word * SET_WORD_BITS + countTrailingZeroes(bits)]);
+                bits &= bits - 1;
+            }
+        }
     }
-    return adjacency;
+    facets.offsets.push_back(facets.vertices.size());
+    buildFacets(vertices, normals, facets);
 }
 
+
+// Into cddlib's B A1 A2 A3 >= 0, see the XXX in solveSnapshot() for the whole story
+void writeRow(dd_MatrixPtr matrix, int row, glm::vec4 coeff, EquationType type) {
+    switch (type) {
+        case EquationType::EQUAL_TO: {
+            set_addelem(matrix->linset, row + 1);
+        }
+        case EquationType::LESS_EQUAL_THAN: {
+            coeff = coeff * glm::vec4({ -1, -1, -1,  1 });
+            break;
+        }
+        case EquationType::GREATER_EQUAL_THAN: {
+            coeff = coeff * glm::vec4({  1,  1,  1, -1 });
+            break;
+        }
+    }
+    dd_set_d(matrix->matrix[row][0], coeff.w);
+    dd_set_d(matrix->matrix[row][1], coeff.x);
+    dd_set_d(matrix->matrix[row][2], coeff.y);
+    dd_set_d(matrix->matrix[row][3], coeff.z);
+}
 #endif // USE_CDDLIB
 
 /**
- * FIXME: This whole thing isn't thread-safe. At all. Which is a candidate
- * to a change, don't want to hang rendering for too long with calculations.
+ * Holds on to the polyhedron from the previous solve along with which planes went into it.
+ * Only the worker doing the solve touches its insides; the problem itself just swaps
+ * the pointer out whenever the existing rows change.
+ */
+struct LinearProgrammingProblem::PolyhedraCache {
+    #ifdef USE_CDDLIB
+    dd_PolyhedraPtr polyhedra = nullptr;
+    // Snapshot plane behind each row. Presolve skips some, so a row count alone wouldn't say which
+    std::vector<uint32_t> planes;
+
+    void reset(dd_PolyhedraPtr replacement, const std::vector<uint32_t>& rowPlanes) {
+        if (polyhedra != nullptr) dd_FreePolyhedra(polyhedra);
+        polyhedra = replacement;
+        planes = rowPlanes;
+    }
+
+    ~PolyhedraCache() { reset(nullptr, {}); }
+    #endif
+};
+
+const size_t DEFAULT_SOLUTION_CACHE_BYTES = 32 << 20;
+// Presolve's redundancy LPs run inside every solve, solveAsync()'s worker and solveBatch()'s included,
+// so they don't get the whole machine. Each thread copies every row, and under a few hundred rows
+// a thread costs more than it saves anyway
+const int PRESOLVE_MAX_THREADS = 2;
+const size_t PRESOLVE_ROWS_PER_THREAD = 512;
+
+template <typename Type>
+size_t getVectorBytes(const std::vector<Type>& vector) { return vector.capacity() * sizeof(Type); }
+
+/**
+ * Plain LRU: a list of entries, most recently used up front, and a hash index into it.
+ * Hashes can collide, so a hit still compares the whole key.
+ * Stored facets and redundant planes count by key row instead of by plane, since whoever hits
+ * the entry later might have their planes in a different order.
+ */
+struct LinearProgrammingProblem::SolutionCache {
+    struct Entry {
+        SolutionKey key;
+        Solution solution;
+        size_t bytes;
+    };
+    typedef std::list<Entry>::iterator EntryIterator;
+
+    std::list<Entry> entries;
+    std::unordered_multimap<uint64_t, EntryIterator> entriesByHash;
+    size_t bytes = 0;
+    size_t capacityBytes = DEFAULT_SOLUTION_CACHE_BYTES;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    static bool isSameKey(const SolutionKey& one, const SolutionKey& other) {
+        if (one.hash != other.hash || one.rows.size() != other.rows.size()) return false;
+        if (one.objectiveFunction != other.objectiveFunction || one.doMinimize != other.doMinimize) return false;
+        if (one.engine != other.engine || one.enumeration != other.enumeration || one.dropRedundant != other.dropRedundant) return false;
+        for (size_t row = 0; row < one.rows.size(); row++) {
+            if (one.rows[row].type != other.rows[row].type) return false;
+            if (one.rows[row].equationCoefficients != other.rows[row].equationCoefficients) return false;
+        }
+        return true;
+    }
+
+    static size_t getEntryBytes(const Entry& entry) {
+        const Solution& solution = entry.solution;
+        // The list node and the index node are a few pointers each
+        return sizeof(Entry) + 8 * sizeof(void*)
+            + getVectorBytes(entry.key.rows) + getVectorBytes(entry.key.planes)
+            + solution.errorString.capacity() + solution.statusString.capacity()
+            + getVectorBytes(solution.polyhedraVertices) + getVectorBytes(solution.polyhedraRays)
+            + getVectorBytes(solution.adjacency.offsets) + getVectorBytes(solution.adjacency.neighbours)
+            + getVectorBytes(solution.facets.offsets) + getVectorBytes(solution.facets.vertices)
+            + getVectorBytes(solution.facets.planes) + getVectorBytes(solution.redundantPlanes);
+    }
+
+    EntryIterator findEntry(const SolutionKey& key) {
+        auto matches = entriesByHash.equal_range(key.hash);
+        for (auto match = matches.first; match != matches.second; match++) {
+            if (isSameKey(match->second->key, key)) return match->second;
+        }
+        return entries.end();
+    }
+
+    void erase(EntryIterator entry) {
+        auto matches = entriesByHash.equal_range(entry->key.hash);
+        for (auto match = matches.first; match != matches.second; match++) {
+            if (match->second != entry) continue;
+            entriesByHash.erase(match);
+            break;
+        }
+        bytes -= entry->bytes;
+        entries.erase(entry);
+    }
+
+    void evict(size_t capacity) {
+        while (bytes > capacity && !entries.empty()) erase(std::prev(entries.end()));
+    }
+
+    // Counts as a hit or a miss. Returns nullptr on a miss
+    const Solution* find(const SolutionKey& key) {
+        EntryIterator entry = findEntry(key);
+        if (entry == entries.end()) {
+            misses++;
+            return nullptr;
+        }
+        hits++;
+        entries.splice(entries.begin(), entries, entry);
+        return &entry->solution;
+    }
+
+    void insert(const SolutionKey& key, const Solution& solution) {
+        EntryIterator existing = findEntry(key);
+        if (existing != entries.end()) erase(existing);
+
+        Entry entry { key, solution, 0 };
+        std::vector<uint32_t> rowOfPlane(key.planes.size());
+        for (size_t row = 0; row < key.planes.size(); row++) rowOfPlane[key.planes[row]] = row;
+        for (uint32_t& plane : entry.solution.facets.planes) plane = rowOfPlane[plane];
+        for (uint32_t& plane : entry.solution.redundantPlanes) plane = rowOfPlane[plane];
+        entry.bytes = getEntryBytes(entry);
+        if (entry.bytes > capacityBytes) return; // Wouldn't fit even on its own
+
+        entries.push_front(std::move(entry));
+        entriesByHash.emplace(key.hash, entries.begin());
+        bytes += entries.front().bytes;
+        evict(capacityBytes);
+    }
+};
+
+#ifdef USE_CDDLIB
+SolverContext::SolverContext() { dd_set_global_constants(); }
+SolverContext::~SolverContext() { dd_free_global_constants(); }
+#else
+SolverContext::SolverContext() {}
+SolverContext::~SolverContext() {}
+#endif
+
+// Function-local static, so initialization is thread-safe and it's gone at exit.
+SolverContext& SolverContext::get() {
+    static SolverContext context;
+    return context;
+}
+
+/**
+ * NOTE: The instance itself still isn't thread-safe, only solveSnapshot() is.
+ * solveAsync() gets around that by handing a copy of the system to a worker thread
+ * and publishing the result back from pollSolution(). Separate instances can solve
+ * on separate threads, cddlib calls get serialized by SolverContext.
 */
 // class LinearProgrammingProblem {
 // protected:
 
+/**
+ * Drops every plane that got zeroed out since the last call, in one pass.
+ * Survivors slide down over the gaps in order, and Display hears about it once through onPlanesCompacted().
+ * Cheap to call when there's nothing to collect, so do it once a frame and before solving.
+ */
 void LinearProgrammingProblem::collectPointless() {
-    // It never gets better, does it?
-    // I hope they're sorted
-    for (const int index : this->pointlessEquations)
-        this->removeLimitPlane(index);
+    if (this->pointlessEquations.empty()) return;
+
+    std::vector<bool> isPointless(planeEquations.size(), false);
+    bool hasPointless = false;
+    for (const PlaneHandle& handle : this->pointlessEquations) {
+        int planeIndex = this->getPlaneIndex(handle);
+        if (planeIndex < 0) continue;
+        // Might've gotten some numbers back since
+        if (this->planeEquations[planeIndex].equationCoefficients != glm::vec4(0)) continue;
+        isPointless[planeIndex] = true;
+        hasPointless = true;
+    }
     this->pointlessEquations.clear();
+    if (!hasPointless) return;
+
+    std::vector<int> survivors;
+    survivors.reserve(planeEquations.size());
+    for (size_t planeIndex = 0; planeIndex < planeEquations.size(); planeIndex++) {
+        uint32_t slot = this->planeSlotIndices[planeIndex];
+        if (isPointless[planeIndex]) {
+            this->planeSlots[slot].generation++;
+            this->freeSlots.push_back(slot);
+            continue;
+        }
+        size_t target = survivors.size();
+        planeEquations[target] = planeEquations[planeIndex];
+        this->planeSlotIndices[target] = slot;
+        this->planeSlots[slot].denseIndex = target;
+        survivors.push_back(planeIndex);
+    }
+    planeEquations.resize(survivors.size());
+    this->planeSlotIndices.resize(survivors.size());
+    this->polyhedraCache.reset();
+    this->constraintsRevision++;
+    onPlanesCompacted(survivors);
 }
 
 //  public:
 
 LinearProgrammingProblem::LinearProgrammingProblem() {
     this->planeEquations = std::vector<Equation>();
-    this->pointlessEquations = std::vector<int>();
+    this->pointlessEquations = std::vector<PlaneHandle>();
+    this->solutionCache = std::make_unique<SolutionCache>();
 };
 LinearProgrammingProblem::~LinearProgrammingProblem() {
     this->planeEquations.clear();
     this->pointlessEquations.clear();
 };
 
-int LinearProgrammingProblem::getEquationCount() {
-    this->collectPointless();
+int LinearProgrammingProblem::getEquationCount() const {
     return planeEquations.size();
 }
-int LinearProgrammingProblem::addLimitPlane(glm::vec4 constraints) {
+PlaneHandle LinearProgrammingProblem::addLimitPlane(glm::vec4 constraints) {
     return addLimitPlane(constraints, EquationType::LESS_EQUAL_THAN);
 }
-int LinearProgrammingProblem::addLimitPlane(glm::vec4 constraints, EquationType equationType) {
-    if (constraints.x != 0 || constraints.y != 0 || constraints.z != 0 || constraints.w != 0) {
-        planeEquations.push_back(Equation{constraints, equationType});
-        onPlaneAdded(planeEquations.size() - 1);
+// Returns a handle that never resolves if the plane was all zeroes and didn't get added
+PlaneHandle LinearProgrammingProblem::addLimitPlane(glm::vec4 constraints, EquationType equationType) {
+    if (constraints.x == 0 && constraints.y == 0 && constraints.z == 0 && constraints.w == 0) return PlaneHandle();
+
+    uint32_t slot;
+    if (!this->freeSlots.empty()) {
+        slot = this->freeSlots.back();
+        this->freeSlots.pop_back();
+    } else {
+        slot = this->planeSlots.size();
+        this->planeSlots.push_back(PlaneSlot());
     }
-    return planeEquations.size();
+    this->planeSlots[slot].denseIndex = planeEquations.size();
+    this->planeSlotIndices.push_back(slot);
+    planeEquations.push_back(Equation{constraints, equationType});
+    this->constraintsRevision++;
+    onPlaneAdded(planeEquations.size() - 1);
+    return PlaneHandle{slot, this->planeSlots[slot].generation};
+}
+
+// @throws: std::out_of_range
+PlaneHandle LinearProgrammingProblem::getPlaneHandle(int planeIndex) const {
+    uint32_t slot = this->planeSlotIndices.at(planeIndex);
+    return PlaneHandle{slot, this->planeSlots[slot].generation};
+}
+// -1 if the plane is gone
+int LinearProgrammingProblem::getPlaneIndex(PlaneHandle handle) const {
+    if (handle.slot >= this->planeSlots.size()) return -1;
+    const PlaneSlot& slot = this->planeSlots[handle.slot];
+    if (slot.generation != handle.generation) return -1;
+    return slot.denseIndex;
+}
+bool LinearProgrammingProblem::isValid(PlaneHandle handle) const {
+    return this->getPlaneIndex(handle) >= 0;
 }
 
 // @throws: std::out_of_range
 LinearProgrammingProblem::Equation LinearProgrammingProblem::getLimitPlane(int planeIndex) {
     return planeEquations.at(planeIndex);
 }
+// @throws: std::out_of_range if the handle went stale
+LinearProgrammingProblem::Equation LinearProgrammingProblem::getLimitPlane(PlaneHandle handle) {
+    return planeEquations.at(this->getPlaneIndex(handle));
+}
 
 void LinearProgrammingProblem::editLimitPlane(int planeIndex, glm::vec4 constraints) {
     editLimitPlane(planeIndex, constraints, EquationType::LESS_EQUAL_THAN);
@@ -157,44 +525,282 @@ void LinearProgrammingProblem::editLimitPlane(int planeIndex, glm::vec4 constrai
 void LinearProgrammingProblem::editLimitPlane(int planeIndex, glm::vec4 constraints, EquationType equationType) {
     planeEquations[planeIndex].equationCoefficients = constraints;
     planeEquations[planeIndex].type = equationType;
+    this->polyhedraCache.reset();
+    this->constraintsRevision++;
     onPlaneUpdated(planeIndex);
     // recalculatePlane(planeIndex);
     if (constraints.x == 0 && constraints.y == 0 && constraints.z == 0 && constraints.w == 0)
-        this->pointlessEquations.push_back(planeIndex);
+        this->pointlessEquations.push_back(this->getPlaneHandle(planeIndex));
+}
+void LinearProgrammingProblem::editLimitPlane(PlaneHandle handle, glm::vec4 constraints, EquationType equationType) {
+    int planeIndex = this->getPlaneIndex(handle);
+    if (planeIndex < 0) return;
+    editLimitPlane(planeIndex, constraints, equationType);
 }
 
-void LinearProgrammingProblem::removeLimitPlane() {
+/**
+ * O(1) removal: the last plane moves into the freed spot, so nothing past it has to shift.
+ * That means the order isn't kept, which is what the handles are for.
+ */
+void LinearProgrammingProblem::removeDense(int planeIndex) {
+    uint32_t slot = this->planeSlotIndices[planeIndex];
+    this->planeSlots[slot].generation++;
+    this->freeSlots.push_back(slot);
+
+    size_t lastIndex = planeEquations.size() - 1;
+    if (planeIndex != lastIndex) {
+        planeEquations[planeIndex] = planeEquations[lastIndex];
+        this->planeSlotIndices[planeIndex] = this->planeSlotIndices[lastIndex];
+        this->planeSlots[this->planeSlotIndices[planeIndex]].denseIndex = planeIndex;
+    }
     planeEquations.pop_back();
-    onPlaneRemoved(planeEquations.size());
+    this->planeSlotIndices.pop_back();
+    this->polyhedraCache.reset();
+    this->constraintsRevision++;
+    onPlaneRemoved(planeIndex);
+}
+
+void LinearProgrammingProblem::removeLimitPlane() {
+    if (planeEquations.empty()) return;
+    this->removeDense(planeEquations.size() - 1);
 }
 void LinearProgrammingProblem::removeLimitPlane(int planeIndex) {
     if (planeIndex < 0 || planeIndex >= planeEquations.size()) return;
-    planeEquations.erase(planeEquations.begin() + planeIndex);
-    onPlaneRemoved(planeIndex);
+    this->removeDense(planeIndex);
+}
+void LinearProgrammingProblem::removeLimitPlane(PlaneHandle handle) {
+    int planeIndex = this->getPlaneIndex(handle);
+    if (planeIndex < 0) return;
+    this->removeDense(planeIndex);
 }
 
 void LinearProgrammingProblem::reset() {
-    auto problems = getEquationCount();
-    for (int idx = 0; idx < problems; idx++) {
-        this->removeLimitPlane(idx);
+    // Everything goes at once, onReset() takes care of the Display side
+    for (uint32_t slot : this->planeSlotIndices) {
+        this->planeSlots[slot].generation++;
+        this->freeSlots.push_back(slot);
     }
+    this->planeSlotIndices.clear();
     this->planeEquations.clear();
     this->pointlessEquations.clear();
+    this->polyhedraCache.reset();
+    this->constraintsRevision++;
     this->objectiveFunction = {0, 0, 0, 0};
     // Light GC but reaaally we should just delete/remake it
     this->solution.adjacency.clear();
+    this->solution.facets.clear();
     this->solution.polyhedraVertices.clear();
+    this->solution.polyhedraRays.clear();
+    this->solution.regionId = 0;
     this->solution.isSolved = false;
+    this->discardPendingSolution = this->isSolving();
     this->onReset();
 }
 
 template <typename dd_Type>
 using dd_unique_ptr = std::unique_ptr<dd_Type, void(*)(dd_Type*)>;
 
+double SolveStats::getTotalMicroseconds() const {
+    double total = 0;
+    for (int stage = 0; stage < SOLVE_STAGE_COUNT; stage++) total += this->stageMicroseconds[stage];
+    return total;
+}
+
+const char* SolveStats::getStageName(SolveStage stage) {
+    switch (stage) {
+        case STAGE_PRESOLVE: return "presolve";
+        case STAGE_SEIDEL: return "seidel";
+        case STAGE_DUAL_HULL: return "dual_hull";
+        case STAGE_CDDLIB_WAIT: return "cddlib_wait";
+        case STAGE_MATRIX: return "matrix";
+        case STAGE_MATRIX_TO_LP: return "matrix_to_lp";
+        case STAGE_LP_SOLVE: return "lp_solve";
+        case STAGE_DOUBLE_DESCRIPTION: return "double_description";
+        case STAGE_COPY_GENERATORS: return "copy_generators";
+        case STAGE_COPY_ADJACENCY: return "copy_adjacency";
+        case STAGE_COPY_INCIDENCE: return "copy_incidence";
+        case STAGE_CONVERT: return "convert";
+        case STAGE_ADJACENCY: return "adjacency";
+        case STAGE_FACETS: return "facets";
+        case STAGE_OBJECTIVE_ONLY: return "objective_only";
+        default: return "unknown";
+    }
+}
+
+#ifdef USE_SOLVE_STATS
+/**
+ * Laps, not scopes: lap() charges everything since the previous lap to the given stage,
+ * so every stage costs one clock read and the gaps between them don't go missing.
+ */
+class StageTimer {
+    private:
+    typedef std::chrono::steady_clock Clock;
+    SolveStats& stats;
+    Clock::time_point lastLap;
+
+    public:
+    StageTimer(SolveStats& stats): stats(stats), lastLap(Clock::now()) { stats.hasTimings = true; }
+    void lap(SolveStage stage) {
+        Clock::time_point now = Clock::now();
+        stats.stageMicroseconds[stage] += std::chrono::duration<double, std::micro>(now - lastLap).count();
+        lastLap = now;
+    }
+};
+#else
+// Nothing to see here, the optimizer gets rid of all of it
+class StageTimer {
+    public:
+    StageTimer(SolveStats& stats) {}
+    void lap(SolveStage stage) {}
+};
+#endif
+
+// Counts only, timings are StageTimer's
+void countSolution(SolveStats& stats, size_t rowCount, const std::vector<float>& vertices, const std::vector<float>& rays, const Adjacency& adjacency, const FacetIncidence& facets) {
+    stats.rowCount = rowCount;
+    stats.vertexCount = vertices.size() / 3;
+    stats.rayCount = rays.size() / 3;
+    stats.edgeCount = adjacency.getEdgeCount();
+    stats.facetCount = facets.getFacetCount();
+}
+
+/**
+ * Copies out the current system, so the solver could chew on it
+ * without us worrying about the UI editing planes mid-solve.
+ */
+LinearProgrammingProblem::Snapshot LinearProgrammingProblem::takeSnapshot() {
+    if (!this->polyhedraCache) this->polyhedraCache = std::make_shared<PolyhedraCache>();
+    return Snapshot{ this->planeEquations, this->objectiveFunction, this->doMinimize, this->engine, this->enumeration, this->polyhedraCache, this->dropRedundantRows };
+}
+
+// Exact matches only, so hashing the bits is fine. -0 is taken care of before it gets here
+struct DirectionHash {
+    size_t operator()(const glm::dvec3& direction) const {
+        uint64_t hash = 14695981039346656037ull;
+        for (int component = 0; component < 3; component++) {
+            uint64_t bits;
+            std::memcpy(&bits, &direction[component], sizeof(bits));
+            hash = (hash ^ bits) * 1099511628211ull;
+        }
+        return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+};
+
+/**
+ * Drops rows that can't change the region before anything gets solved: scaled copies
+ * of another row, and parallel rows facing the same way as a tighter one.
+ * Each row gets boiled down to d.x <= b, d.x >= b or d.x = b, with d scaled so its largest
+ * component is 1 and flipped so its first non-zero one is positive. That way every row
+ * of a parallel family lands on the same d, whatever its scale or sense, and only the
+ * tightest bound each way (or the equality, if there is one) has to stay.
+ * Only exact matches count as parallel; rows a rounding error apart are left to the solver.
+ * Conflicting equalities all stay as well, cddlib is the one to call those infeasible.
+ * With dropRedundant on, whatever survives that gets one LP each (see classifyRows())
+ * and goes too if it doesn't touch the region at all. Those run on at most PRESOLVE_MAX_THREADS threads.
+ * keptPlanes maps the rows that are left back to the snapshot's planes, order kept,
+ * redundantPlanes gets the rest.
+ */
+LinearProgrammingProblem::Snapshot LinearProgrammingProblem::presolve(const Snapshot& snapshot, std::vector<uint32_t>& keptPlanes, std::vector<uint32_t>& redundantPlanes) {
+    enum Sense { UPPER, LOWER, EQUAL };
+    struct Family {
+        int upper = -1; // Tightest one of each, as plane indices
+        int lower = -1;
+        int equal = -1;
+    };
+    const auto& planeEquations = snapshot.planeEquations;
+    std::vector<double> bounds(planeEquations.size());
+    std::vector<bool> isRedundant(planeEquations.size(), false);
+    std::unordered_map<glm::dvec3, Family, DirectionHash> families;
+    families.reserve(planeEquations.size());
+
+    // Ties go to the one that came first
+    auto keepTighter = [&isRedundant](int& current, int plane, bool isTighter) {
+        if (current >= 0 && !isTighter) {
+            isRedundant[plane] = true;
+            return;
+        }
+        if (current >= 0) isRedundant[current] = true;
+        current = plane;
+    };
+    for (size_t plane = 0; plane < planeEquations.size(); plane++) {
+        glm::dvec4 coefficients = glm::dvec4(planeEquations[plane].equationCoefficients);
+        glm::dvec3 direction = glm::dvec3(coefficients);
+        double scale = std::max(std::max(std::abs(direction.x), std::abs(direction.y)), std::abs(direction.z));
+        if (scale == 0) continue; // 0 <= B is either always true or never, not our call
+        Sense sense = planeEquations[plane].type == EquationType::LESS_EQUAL_THAN ? UPPER
+                    : planeEquations[plane].type == EquationType::GREATER_EQUAL_THAN ? LOWER : EQUAL;
+        for (int component = 0; component < 3; component++) {
+            if (direction[component] == 0) continue;
+            if (direction[component] < 0) {
+                scale = -scale;
+                if (sense != EQUAL) sense = sense == UPPER ? LOWER : UPPER;
+            }
+            break;
+        }
+        direction = direction / scale + glm::dvec3(0);
+        bounds[plane] = coefficients.w / scale;
+
+        Family& family = families[direction];
+        switch (sense) {
+            case UPPER: keepTighter(family.upper, plane, family.upper >= 0 && bounds[plane] < bounds[family.upper]); break;
+            case LOWER: keepTighter(family.lower, plane, family.lower >= 0 && bounds[plane] > bounds[family.lower]); break;
+            case EQUAL:
+                if (family.equal < 0) family.equal = plane;
+                else if (bounds[plane] == bounds[family.equal]) isRedundant[plane] = true;
+                break;
+        }
+    }
+    // Whatever the equality pins down, the inequalities on its side of it say nothing more
+    for (auto& entry : families) {
+        const Family& family = entry.second;
+        if (family.equal < 0) continue;
+        double bound = bounds[family.equal];
+        if (family.upper >= 0 && bounds[family.upper] >= bound) isRedundant[family.upper] = true;
+        if (family.lower >= 0 && bounds[family.lower] <= bound) isRedundant[family.lower] = true;
+    }
+
+    // What's left is parallel to nothing, so one LP per row can tell whether it touches the region at all
+    if (snapshot.dropRedundant) {
+        std::vector<Equation> survivors;
+        std::vector<uint32_t> survivorPlanes;
+        for (size_t plane = 0; plane < planeEquations.size(); plane++) {
+            if (isRedundant[plane]) continue;
+            survivors.push_back(planeEquations[plane]);
+            survivorPlanes.push_back(plane);
+        }
+        int threadCount = static_cast<int>(std::min<size_t>(PRESOLVE_MAX_THREADS, 1 + survivors.size() / PRESOLVE_ROWS_PER_THREAD));
+        std::vector<ConstraintClass> classes = classifyRows(survivors, threadCount, true);
+        for (size_t row = 0; row < survivors.size(); row++) {
+            if (classes[row] == CONSTRAINT_REDUNDANT) isRedundant[survivorPlanes[row]] = true;
+        }
+    }
+
+    Snapshot presolved { {}, snapshot.objectiveFunction, snapshot.doMinimize, snapshot.engine, snapshot.enumeration, snapshot.polyhedra, snapshot.dropRedundant };
+    presolved.planeEquations.reserve(planeEquations.size());
+    keptPlanes.clear();
+    keptPlanes.reserve(planeEquations.size());
+    redundantPlanes.clear();
+    for (size_t plane = 0; plane < planeEquations.size(); plane++) {
+        if (isRedundant[plane]) {
+            redundantPlanes.push_back(plane);
+            continue;
+        }
+        presolved.planeEquations.push_back(planeEquations[plane]);
+        keptPlanes.push_back(plane);
+    }
+    return presolved;
+}
+
 /** 
- * Solves the given LPP and return boolean if a solution was found.
+ * Solves the given snapshot of an LPP and returns the solution.
  * If the provided system is invalid, don't throw but set solution.isSolved to false
  * Query solution.statusString for details.
+ * Doesn't touch any instance, so it's safe to run on any number of worker threads.
+ * Seidel and the dual hull run in parallel just fine; whatever has to go through cddlib
+ * takes SolverContext's lock first, so those solves queue up.
+ * The only shared thing it modifies is the snapshot's PolyhedraCache,
+ * which nobody else looks into while the solve runs.
+ * cddlib's globals come from SolverContext and outlive the call.
  * 
  * NOTE: with dd_unique_ptr wrapper it's less likely to throw a segfault than plainly..
  *      deleting them after an exception is caught/scope exited, but who knows.
@@ -204,63 +810,79 @@ using dd_unique_ptr = std::unique_ptr<dd_Type, void(*)(dd_Type*)>;
  *      I'd much rather write this comment :P
  * @throws std::runtime_error if there's something really wrong with the provided system
  */
-void LinearProgrammingProblem::solve() {
-    this->collectPointless();
+LinearProgrammingProblem::Solution LinearProgrammingProblem::solveSnapshot(const Snapshot& snapshot) {
+    Solution solution;
+    StageTimer timer(solution.stats);
+    // From here on it's all presolved rows, keptPlanes takes them back to the snapshot's planes
+    std::vector<uint32_t> keptPlanes;
+    const Snapshot presolved = presolve(snapshot, keptPlanes, solution.redundantPlanes);
+    solution.stats.redundantRowCount = solution.redundantPlanes.size();
+    timer.lap(STAGE_PRESOLVE);
+    const auto& planeEquations = presolved.planeEquations;
+    const auto& objectiveFunction = presolved.objectiveFunction;
+    // Seidel goes first if asked to, cddlib's simplex only runs if it gave up
+    bool isOptimumFound = presolved.engine == SolverEngine::ENGINE_SEIDEL && solveSeidel(presolved, solution);
+    timer.lap(STAGE_SEIDEL);
+    // Bounded regions with some volume to them go through the dual hull instead, if asked to
+    bool isEnumerated = presolved.enumeration == EnumerationEngine::ENUMERATION_NONE
+        || (presolved.enumeration == EnumerationEngine::ENUMERATION_DUAL_HULL
+            && intersectHalfspaces(getHalfspaces(planeEquations), solution.polyhedraVertices, solution.adjacency, solution.facets));
+    timer.lap(STAGE_DUAL_HULL);
+    if (isEnumerated && presolved.enumeration == EnumerationEngine::ENUMERATION_DUAL_HULL) {
+        // Facets came back numbered by halfspace, equalities took up two of those
+        std::vector<uint32_t> halfspacePlanes;
+        halfspacePlanes.reserve(planeEquations.size() * 2);
+        for (size_t plane = 0; plane < planeEquations.size(); plane++) {
+            halfspacePlanes.push_back(keptPlanes[plane]);
+            if (planeEquations[plane].type == EquationType::EQUAL_TO) halfspacePlanes.push_back(keptPlanes[plane]);
+        }
+        for (uint32_t& plane : solution.facets.planes) plane = halfspacePlanes[plane];
+    }
     // Yes we use #ifdef and I know it's bad, but I have to build it somehow on Windows first.
     #ifdef USE_CDDLIB
-    /**
-     */
+    if (isOptimumFound && isEnumerated) {
+        countSolution(solution.stats, planeEquations.size(), solution.polyhedraVertices, solution.polyhedraRays, solution.adjacency, solution.facets);
+        return solution;
+    }
+
+    // Before the dd_unique_ptrs, so they get freed while it's still held
+    SolverContext& context = SolverContext::get();
+    std::lock_guard<std::mutex> cddlibLock(context.lock);
+    timer.lap(STAGE_CDDLIB_WAIT);
     dd_unique_ptr<dd_LPType>    linearProgrammingProblem(nullptr, dd_FreeLPData);
     dd_unique_ptr<dd_MatrixType> constraintMatrix(nullptr, dd_FreeMatrix);
     dd_unique_ptr<dd_MatrixType> verticesMatrix(nullptr, dd_FreeMatrix);
     dd_unique_ptr<dd_SetFamilyType> adjacency(nullptr, dd_FreeSetFamily);
+    dd_unique_ptr<dd_SetFamilyType> incidence(nullptr, dd_FreeSetFamily);
     dd_unique_ptr<dd_PolyhedraType> polyhedra(nullptr, dd_FreePolyhedra);
     dd_ErrorType error;
-    try {
-    dd_set_global_constants();
-
-    solution = Solution();
-
-    constraintMatrix.reset(dd_CreateMatrix(this->planeEquations.size(), 4));
-
-    int row;
-    for (row = 0; row < planeEquations.size(); row++) {
-        // Ah yes I love doing stuff this way. Just can't get enough of it.
-        // *sarcarsm please don't judge*
-        /** XXX: cddlib expects us to provide the constraints in a different form
-         * it expects the form of:
-         * B A1 A2 A3 >= 0
-         * but we collect them in form of
-         * A1 A2 A3 {Equation.type} B
-         * so we have to either:
-         * a) multiply A's (planeEquation.xyz) by -1
-         *    and shift B (planeEquation.w) to the first column.
-         *    if {Equation.type} is LESS_EQUAL_THAN (<=)
-         * b) multiply B (planeEquation.w) by -1, shift it to the first column
-         *    and leave rest intact
-         *    if {Equation.type} is GREATER_EQUAL_THAN (>=)
-         * c) do the same as a) but add current equation index + 1 to the "linset"
-         *    set of the matrix because of course that's a thing that expands them to equality automatically.
-         */
-        const auto planeEquation = planeEquations.at(row);
-        glm::vec4 coeff = planeEquation.equationCoefficients;
-        switch (planeEquation.type) {
-            case EquationType::EQUAL_TO: {
-                set_addelem(constraintMatrix.get()->linset, row + 1);
-            }
-            case EquationType::LESS_EQUAL_THAN: {
-                coeff = coeff * glm::vec4({ -1, -1, -1,  1 });
-                break;
-            }
-            case EquationType::GREATER_EQUAL_THAN: {
-                coeff = coeff * glm::vec4({  1,  1,  1, -1 });
-                break;
-            }
-        }
-        dd_set_d(constraintMatrix->matrix[row][0], coeff.w);
-        dd_set_d(constraintMatrix->matrix[row][1], coeff.x);
-        dd_set_d(constraintMatrix->matrix[row][2], coeff.y);
-        dd_set_d(constraintMatrix->matrix[row][3], coeff.z);
+
+    // Ah yes I love doing stuff this way. Just can't get enough of it.
+    // *sarcarsm please don't judge*
+    /** XXX: cddlib expects us to provide the constraints in a different form
+     * it expects the form of:
+     * B A1 A2 A3 >= 0
+     * but we collect them in form of
+     * A1 A2 A3 {Equation.type} B
+     * so we have to either:
+     * a) multiply A's (planeEquation.xyz) by -1
+     *    and shift B (planeEquation.w) to the first column.
+     *    if {Equation.type} is LESS_EQUAL_THAN (<=)
+     * b) multiply B (planeEquation.w) by -1, shift it to the first column
+     *    and leave rest intact
+     *    if {Equation.type} is GREATER_EQUAL_THAN (>=)
+     * c) do the same as a) but add current equation index + 1 to the "linset"
+     *    set of the matrix because of course that's a thing that expands them to equality automatically.
+     */
+    auto writeRow = [](dd_MatrixPtr matrix, int row, const Equation& planeEquation) {
+        ::writeRow(matrix, row, planeEquation.equationCoefficients, planeEquation.type);
+    };
+
+    const size_t rowCount = planeEquations.size();
+    constraintMatrix.reset(dd_CreateMatrix(rowCount, 4));
+
+    for (int row = 0; row < rowCount; row++) {
+        writeRow(constraintMatrix.get(), row, planeEquations.at(row));
     }
     // for (int diag = 0; diag < 3; diag++) {
     //     // -This way we set the x1, x2, x3 >= 0 condition
@@ -279,35 +901,457 @@ void LinearProgrammingProblem::solve() {
     dd_set_d(constraintMatrix->rowvec[3], objectiveFunction.z);
 
     constraintMatrix->representation = dd_Inequality;
-    constraintMatrix->objective = this->doMinimize ? dd_LPmin : dd_LPmax;
-
-    linearProgrammingProblem.reset(dd_Matrix2LP(constraintMatrix.get(), &error));
-    throw_dd_error(error);
-    polyhedra.reset(dd_DDMatrix2Poly(constraintMatrix.get(), &error));
-    throw_dd_error(error);
-    dd_LPSolve(linearProgrammingProblem.get(), dd_DualSimplex, &error);
-    throw_dd_error(error);
-
-    verticesMatrix.reset(dd_CopyGenerators(polyhedra.get()));
-    adjacency.reset(dd_CopyAdjacency(polyhedra.get()));
-
-    solution.isSolved = linearProgrammingProblem->LPS == dd_LPStatusType::dd_Optimal;
-    solution.statusString = reflect_lp_status(linearProgrammingProblem->LPS);
-    solution.optimalValue = linearProgrammingProblem->optvalue[0];
-    solution.optimalVector = createVector(linearProgrammingProblem->sol, linearProgrammingProblem->d);
-    solution.didMinimize = linearProgrammingProblem->objective == dd_LPmin;
-    solution.polyhedraVertices = getVertices(verticesMatrix.get());
-    solution.adjacency = getAdjacency(adjacency.get());
+    constraintMatrix->objective = presolved.doMinimize ? dd_LPmin : dd_LPmax;
+    timer.lap(STAGE_MATRIX);
+
+    if (!isOptimumFound) {
+        linearProgrammingProblem.reset(dd_Matrix2LP(constraintMatrix.get(), &error));
+        throw_dd_error(error);
+        timer.lap(STAGE_MATRIX_TO_LP);
+        dd_LPSolve(linearProgrammingProblem.get(), dd_DualSimplex, &error);
+        throw_dd_error(error);
+        timer.lap(STAGE_LP_SOLVE);
+
+        solution.isSolved = linearProgrammingProblem->LPS == dd_LPStatusType::dd_Optimal;
+        solution.statusString = reflect_lp_status(linearProgrammingProblem->LPS);
+        solution.optimalValue = linearProgrammingProblem->optvalue[0];
+        solution.optimalVector = createVector(linearProgrammingProblem->sol, linearProgrammingProblem->d);
+        solution.didMinimize = linearProgrammingProblem->objective == dd_LPmin;
+    }
+
+    if (!isEnumerated) {
+        /**
+         * Vertex enumeration is the expensive part, so reuse whatever the previous solve left behind:
+         * - same rows as last time: the polyhedron is still good as is
+         * - rows got appended: feed only those into dd_DDAddInequalities
+         * - anything else, or no cache at all: redo it from scratch
+         * Edits and removals drop the cache on the problem side, so there are no stale rows in here.
+         * dd_DDAddInequalities can't handle linearity, so appended equalities force a rebuild as well.
+         */
+        PolyhedraCache* cache = presolved.polyhedra.get();
+        // An appended plane can knock out an older parallel one, so the kept rows have to match, not just count the same
+        bool canExtend = cache != nullptr && cache->polyhedra != nullptr && cache->planes.size() <= rowCount
+            && std::equal(cache->planes.begin(), cache->planes.end(), keptPlanes.begin());
+        const size_t cachedRowCount = canExtend ? cache->planes.size() : rowCount;
+        for (size_t row = cachedRowCount; row < rowCount; row++) {
+            if (planeEquations[row].type == EquationType::EQUAL_TO) canExtend = false;
+        }
+
+        if (canExtend && cachedRowCount < rowCount) {
+            dd_unique_ptr<dd_MatrixType> appendedRows(dd_CreateMatrix(rowCount - cachedRowCount, 4), dd_FreeMatrix);
+            appendedRows->representation = dd_Inequality;
+            for (size_t row = cachedRowCount; row < rowCount; row++) {
+                writeRow(appendedRows.get(), row - cachedRowCount, planeEquations[row]);
+            }
+            // Whatever cddlib didn't like here, a full rebuild below will either fix or report
+            canExtend = dd_DDAddInequalities(cache->polyhedra, appendedRows.get(), &error) && error == dd_NoError;
+            if (canExtend) cache->planes = keptPlanes;
+        }
+
+        dd_PolyhedraPtr currentPolyhedra = nullptr;
+        if (canExtend) {
+            currentPolyhedra = cache->polyhedra;
+        } else {
+            if (cache != nullptr) cache->reset(nullptr, {});
+            polyhedra.reset(dd_DDMatrix2Poly(constraintMatrix.get(), &error));
+            throw_dd_error(error);
+            currentPolyhedra = polyhedra.get();
+            if (cache != nullptr) cache->reset(polyhedra.release(), keptPlanes);
+        }
+        solution.stats.isPolyhedraCached = canExtend;
+        timer.lap(STAGE_DOUBLE_DESCRIPTION);
+
+        verticesMatrix.reset(dd_CopyGenerators(currentPolyhedra));
+        timer.lap(STAGE_COPY_GENERATORS);
+        adjacency.reset(dd_CopyAdjacency(currentPolyhedra));
+        timer.lap(STAGE_COPY_ADJACENCY);
+        incidence.reset(dd_CopyInputIncidence(currentPolyhedra));
+        timer.lap(STAGE_COPY_INCIDENCE);
+
+        getVertices(verticesMatrix.get(), solution.polyhedraVertices);
+        getRays(verticesMatrix.get(), solution.polyhedraRays);
+        timer.lap(STAGE_CONVERT);
+        getAdjacency(adjacency.get(), verticesMatrix.get(), solution.adjacency);
+        timer.lap(STAGE_ADJACENCY);
+        // Outward is where the row stops holding; equalities are flat, either side goes
+        std::vector<glm::dvec3> normals(rowCount);
+        for (size_t row = 0; row < rowCount; row++) {
+            normals[row] = glm::dvec3(planeEquations[row].equationCoefficients);
+            if (planeEquations[row].type == EquationType::GREATER_EQUAL_THAN) normals[row] = -normals[row];
+        }
+        getFacets(incidence.get(), verticesMatrix.get(), normals, solution.polyhedraVertices, solution.facets);
+        for (uint32_t& plane : solution.facets.planes) plane = keptPlanes[plane];
+        timer.lap(STAGE_FACETS);
+    }
+    #endif
+    countSolution(solution.stats, planeEquations.size(), solution.polyhedraVertices, solution.polyhedraRays, solution.adjacency, solution.facets);
+    return solution;
+}
+
+// Everything as A1 A2 A3 <= B, which is what the native solvers want. Equalities come out as two rows
+std::vector<glm::dvec4> LinearProgrammingProblem::getHalfspaces(const std::vector<Equation>& planeEquations) {
+    std::vector<glm::dvec4> halfspaces;
+    halfspaces.reserve(planeEquations.size() * 2);
+    for (const Equation& planeEquation : planeEquations) {
+        glm::dvec4 coeff = glm::dvec4(planeEquation.equationCoefficients);
+        switch (planeEquation.type) {
+            case EquationType::LESS_EQUAL_THAN: halfspaces.push_back(coeff); break;
+            case EquationType::GREATER_EQUAL_THAN: halfspaces.push_back(-coeff); break;
+            case EquationType::EQUAL_TO: halfspaces.push_back(coeff); halfspaces.push_back(-coeff); break;
+        }
+    }
+    return halfspaces;
+}
+
+/**
+ * Second opinion for whatever classifyRows() left as CONSTRAINT_UNKNOWN: cddlib's own
+ * dd_Redundant and dd_ImplicitLinearity, exact where it counts. One matrix for all of them,
+ * but it's a full LP per row under SolverContext's lock, so only the leftovers go through here.
+ * Rows cddlib errors out on stay unknown.
+ */
+#ifdef USE_CDDLIB
+void LinearProgrammingProblem::classifyWithCddlib(const std::vector<Equation>& planeEquations, std::vector<ConstraintClass>& classes) {
+    if (std::find(classes.begin(), classes.end(), CONSTRAINT_UNKNOWN) == classes.end()) return;
+
+    SolverContext& context = SolverContext::get();
+    std::lock_guard<std::mutex> cddlibLock(context.lock);
+    dd_unique_ptr<dd_MatrixType> constraintMatrix(dd_CreateMatrix(planeEquations.size(), 4), dd_FreeMatrix);
+    constraintMatrix->representation = dd_Inequality;
+    for (size_t row = 0; row < planeEquations.size(); row++) {
+        writeRow(constraintMatrix.get(), row, planeEquations[row].equationCoefficients, planeEquations[row].type);
+    }
+    dd_Arow certificate;
+    dd_InitializeArow(4, &certificate);
+    for (size_t row = 0; row < planeEquations.size(); row++) {
+        if (classes[row] != CONSTRAINT_UNKNOWN) continue;
+        dd_ErrorType error = dd_NoError;
+        // cddlib counts rows from 1
+        bool isRedundant = dd_Redundant(constraintMatrix.get(), row + 1, certificate, &error);
+        if (error != dd_NoError) continue;
+        if (isRedundant) {
+            classes[row] = CONSTRAINT_REDUNDANT;
+            continue;
+        }
+        if (planeEquations[row].type == EquationType::EQUAL_TO) {
+            classes[row] = CONSTRAINT_BINDING;
+            continue;
+        }
+        bool isImplicit = dd_ImplicitLinearity(constraintMatrix.get(), row + 1, certificate, &error);
+        if (error != dd_NoError) continue;
+        classes[row] = isImplicit ? CONSTRAINT_IMPLICIT_EQUALITY : CONSTRAINT_BINDING;
+    }
+    dd_FreeArow(4, certificate);
+}
+#else
+void LinearProgrammingProblem::classifyWithCddlib(const std::vector<Equation>& planeEquations, std::vector<ConstraintClass>& classes) {}
+#endif
+
+/**
+ * Finds the optimum with Seidel's LP instead of cddlib's simplex, filling in the same fields.
+ * Status strings are kept the same as cddlib's, so nobody downstream has to care who solved it.
+ * Returns false if it wasn't sure about the answer, and cddlib should have a go at it.
+ */
+bool LinearProgrammingProblem::solveSeidel(const Snapshot& snapshot, Solution& solution) {
+    std::vector<glm::dvec4> halfspaces = getHalfspaces(snapshot.planeEquations);
+    glm::dvec3 objective = glm::dvec3(snapshot.objectiveFunction);
+    SeidelResult result = seidelMaximize(halfspaces, snapshot.doMinimize ? -objective : objective);
+
+    switch (result.status) {
+        case SEIDEL_DEGENERATE: return false;
+        case SEIDEL_OPTIMAL: solution.statusString = "dd_Optimal"; break;
+        case SEIDEL_INFEASIBLE: solution.statusString = "dd_Inconsistent"; break;
+        case SEIDEL_UNBOUNDED: solution.statusString = "dd_DualInconsistent"; break;
+    }
+    solution.isSolved = result.status == SEIDEL_OPTIMAL;
+    solution.didMinimize = snapshot.doMinimize;
+    solution.optimalVector = glm::vec3(result.point);
+    solution.optimalValue = glm::dot(objective, result.point) + snapshot.objectiveFunction.w;
+    return true;
+}
+
+/**
+ * Answers the solve without going anywhere near cddlib, if only the objective changed since the last one.
+ * The region is the same, so the optimum is either along one of the cached rays (unbounded)
+ * or at one of the cached vertices. Both lists are tiny, so this is a plain scan.
+ * Returns false if the constraints changed and it's a real solve after all.
+ */
+bool LinearProgrammingProblem::solveObjectiveOnly() {
+    if (this->solvedState.constraintsRevision != this->constraintsRevision) return false;
+    if (this->solvedState.engine != this->engine) return false;
+    if (this->solvedState.enumeration != this->enumeration) return false;
+    if (this->solvedState.dropRedundant != this->dropRedundantRows) return false;
+    if (this->solvedState.objectiveFunction == this->objectiveFunction
+     && this->solvedState.doMinimize == this->doMinimize) return true; // Nothing to do
+    if (this->enumeration == EnumerationEngine::ENUMERATION_NONE) return false; // No vertices to pick from
+
+    auto& vertices = this->solution.polyhedraVertices;
+    auto& rays = this->solution.polyhedraRays;
+    bool isInfeasible = this->solution.statusString == "dd_Inconsistent" || this->solution.statusString == "dd_StrucInconsistent";
+    // No vertices on a region that's there after all, nothing to pick from
+    if (vertices.empty() && !isInfeasible) return false;
+
+    this->solvedState.objectiveFunction = this->objectiveFunction;
+    this->solvedState.doMinimize = this->doMinimize;
+    // Same region, so the counts still hold. The time is all this scan's though
+    for (double& stageTime : this->solution.stats.stageMicroseconds) stageTime = 0;
+    this->solution.stats.isPolyhedraCached = true;
+    StageTimer timer(this->solution.stats);
+
+    glm::vec3 objective = glm::vec3(this->objectiveFunction);
+    float direction = this->doMinimize ? -1.0f : 1.0f;
+    this->solution.didMinimize = this->doMinimize;
+
+    // Infeasible stays infeasible, whatever we're optimizing
+    if (isInfeasible) {
+        timer.lap(STAGE_OBJECTIVE_ONLY);
+        this->solutionRevision++;
+        this->onOptimumUpdated();
+        return true;
+    }
+
+    // NOTE: rays come normalized-ish out of cddlib, so a relative epsilon is plenty
+    float epsilon = 1e-6f * glm::length(objective);
+    for (size_t ray = 0; ray + 2 < rays.size(); ray += 3) {
+        if (direction * glm::dot(objective, glm::vec3(rays[ray], rays[ray + 1], rays[ray + 2])) > epsilon) {
+            // Same status cddlib reports for an unbounded primal
+            this->solution.isSolved = false;
+            this->solution.statusString = "dd_DualInconsistent";
+            timer.lap(STAGE_OBJECTIVE_ONLY);
+            this->solutionRevision++;
+            this->onOptimumUpdated();
+            return true;
+        }
+    }
+
+    size_t best = 0;
+    float bestValue = 0;
+    for (size_t vertex = 0; vertex + 2 < vertices.size(); vertex += 3) {
+        float value = direction * glm::dot(objective, glm::vec3(vertices[vertex], vertices[vertex + 1], vertices[vertex + 2]));
+        if (vertex == 0 || value > bestValue) {
+            best = vertex;
+            bestValue = value;
+        }
+    }
+
+    this->solution.isSolved = true;
+    this->solution.statusString = "dd_Optimal";
+    this->solution.optimalVector = glm::vec3(vertices[best], vertices[best + 1], vertices[best + 2]);
+    this->solution.optimalValue = glm::dot(objective, this->solution.optimalVector) + this->objectiveFunction.w;
+    timer.lap(STAGE_OBJECTIVE_ONLY);
+    this->solutionRevision++;
+    this->onOptimumUpdated();
+    return true;
+}
+
+bool LinearProgrammingProblem::isCachingSolutions() const {
+    return this->solutionCache->capacityBytes > 0;
+}
+
+// FNV-1a, a word at a time
+inline void hashWord(uint64_t& hash, uint32_t word) {
+    hash ^= word;
+    hash *= 1099511628211ull;
+}
+
+inline void hashFloats(uint64_t& hash, const glm::vec4& vector) {
+    for (int component = 0; component < 4; component++) {
+        uint32_t bits;
+        std::memcpy(&bits, &vector[component], sizeof(bits));
+        hashWord(hash, bits);
+    }
+}
+
+LinearProgrammingProblem::SolutionKey LinearProgrammingProblem::getSolutionKey() const {
+    SolutionKey key { {}, {}, this->objectiveFunction, this->doMinimize, this->engine, this->enumeration, this->dropRedundantRows };
+    std::vector<Equation> rows;
+    rows.reserve(this->planeEquations.size());
+    for (Equation row : this->planeEquations) {
+        glm::vec4& coefficients = row.equationCoefficients;
+        if (row.type == EquationType::GREATER_EQUAL_THAN) {
+            coefficients = -coefficients;
+            row.type = EquationType::LESS_EQUAL_THAN;
+        }
+        float scale = std::max(std::max(std::abs(coefficients.x), std::abs(coefficients.y)),
+                               std::max(std::abs(coefficients.z), std::abs(coefficients.w)));
+        // Equalities hold either way around, so the first non-zero one gets to be positive
+        if (row.type == EquationType::EQUAL_TO) {
+            for (int component = 0; component < 4; component++) {
+                if (coefficients[component] == 0) continue;
+                if (coefficients[component] < 0) scale = -scale;
+                break;
+            }
+        }
+        if (scale != 0) coefficients /= scale;
+        coefficients += glm::vec4(0); // -0 into 0, they compare equal but wouldn't hash that way
+        rows.push_back(row);
+    }
+
+    key.planes.resize(rows.size());
+    std::iota(key.planes.begin(), key.planes.end(), 0);
+    std::stable_sort(key.planes.begin(), key.planes.end(), [&rows](uint32_t one, uint32_t other) {
+        if (rows[one].type != rows[other].type) return rows[one].type < rows[other].type;
+        for (int component = 0; component < 4; component++) {
+            float left = rows[one].equationCoefficients[component], right = rows[other].equationCoefficients[component];
+            if (left != right) return left < right;
+        }
+        return false;
+    });
+
+    uint64_t hash = 14695981039346656037ull;
+    key.rows.reserve(rows.size());
+    for (uint32_t plane : key.planes) {
+        key.rows.push_back(rows[plane]);
+        hashFloats(hash, rows[plane].equationCoefficients);
+        hashWord(hash, rows[plane].type);
+    }
+    hashFloats(hash, this->objectiveFunction + glm::vec4(0));
+    hashWord(hash, this->doMinimize);
+    hashWord(hash, this->engine);
+    hashWord(hash, this->enumeration);
+    hashWord(hash, this->dropRedundantRows);
+    key.hash = hash;
+    return key;
+}
+
+/**
+ * Puts a solution solved before back in place, if there's one for this key.
+ * It's the same region, just maybe solved with the planes in a different order,
+ * so the facets get their plane indices translated over. Where several vertices are equally
+ * optimal, the one we get back is whichever the first solve picked.
+ */
+bool LinearProgrammingProblem::solveFromCache(const SolutionKey& key, const SolvedState& state) {
+    const Solution* cached = this->solutionCache->find(key);
+    if (cached == nullptr) return false;
+    this->solution = *cached;
+    for (uint32_t& plane : this->solution.facets.planes) plane = key.planes[plane];
+    for (uint32_t& plane : this->solution.redundantPlanes) plane = key.planes[plane];
+    std::sort(this->solution.redundantPlanes.begin(), this->solution.redundantPlanes.end());
+    for (double& stageTime : this->solution.stats.stageMicroseconds) stageTime = 0;
+    this->solution.stats.isSolutionCached = true;
+    this->solvedState = state;
+    this->solutionRevision++;
     onSolutionSolved();
+    return true;
+}
 
+// Freshly solved this->solution goes live: new region, into the cache, out to whoever's listening
+void LinearProgrammingProblem::publishSolution(const SolutionKey& key, const SolvedState& state) {
+    this->solution.regionId = ++this->lastRegionId;
+    if (this->isCachingSolutions()) this->solutionCache->insert(key, this->solution);
+    this->solvedState = state;
+    this->solutionRevision++;
+    onSolutionSolved();
+}
+
+/**
+ * Solves the current system in place, blocking until cddlib is done.
+ * If only the objective changed since the last solve, the old region is reused,
+ * and systems that were solved before come straight out of the solution cache.
+ * A solveAsync() still in flight is for older planes by now, so whatever it brings back gets dropped.
+ * @throws std::runtime_error if there's something really wrong with the provided system
+ */
+void LinearProgrammingProblem::solve() {
+    if (this->isSolving()) this->discardPendingSolution = true;
+    this->collectPointless();
+    if (this->solveObjectiveOnly()) return;
+    SolvedState state = { this->constraintsRevision, this->objectiveFunction, this->doMinimize, this->engine, this->enumeration, this->dropRedundantRows };
+    SolutionKey key;
+    if (this->isCachingSolutions()) {
+        key = this->getSolutionKey();
+        if (this->solveFromCache(key, state)) return;
+    }
+    try {
+        this->solution = solveSnapshot(this->takeSnapshot());
     } catch (std::runtime_error &dd_error) {
-        dd_free_global_constants();
+        this->solution = Solution();
+        this->solvedState = SolvedState();
+        this->solutionRevision++;
         throw dd_error;
     }
-    dd_free_global_constants();
-    #endif
-};
+    this->publishSolution(key, state);
+}
+
+/**
+ * Same as solve(), but off the calling thread. The system is snapshotted right away,
+ * so it's fine to keep editing it while the worker is busy.
+ * The result only lands once pollSolution() picks it up, which is where onSolutionSolved()
+ * fires -- call it from the thread that owns the events (the GL one for Display).
+ * Objective-only changes and solution cache hits are answered right here instead, since they're way cheaper than a thread.
+ * Returns false if there's a solve in flight already.
+ */
+bool LinearProgrammingProblem::solveAsync() {
+    if (this->isSolving()) return false;
+    this->collectPointless();
+    if (this->solveObjectiveOnly()) return true;
+    this->discardPendingSolution = false;
+    this->pendingState = { this->constraintsRevision, this->objectiveFunction, this->doMinimize, this->engine, this->enumeration, this->dropRedundantRows };
+    if (this->isCachingSolutions()) {
+        this->pendingKey = this->getSolutionKey();
+        if (this->solveFromCache(this->pendingKey, this->pendingState)) return true;
+    }
+    this->pendingSolution = std::async(std::launch::async, &LinearProgrammingProblem::solveSnapshot, this->takeSnapshot());
+    return true;
+}
+
+/**
+ * Publishes the result of solveAsync(), if it's ready. Never blocks.
+ * Returns true if the solution was updated.
+ * @throws std::runtime_error forwarded from the worker, same as solve()
+ */
+bool LinearProgrammingProblem::pollSolution() {
+    if (!this->pendingSolution.valid()) return false;
+    if (this->pendingSolution.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+
+    if (this->discardPendingSolution) {
+        // Problem was reset while we were solving, whatever came back is for the old one
+        this->discardPendingSolution = false;
+        try { this->pendingSolution.get(); } catch (std::runtime_error &dd_error) {}
+        return false;
+    }
+
+    try {
+        this->solution = this->pendingSolution.get();
+    } catch (std::runtime_error &dd_error) {
+        this->solution = Solution();
+        this->solvedState = SolvedState();
+        this->solutionRevision++;
+        throw dd_error;
+    }
+    // Planes edited mid-solve keep the revisions apart, so the next solve won't take the shortcut
+    this->publishSolution(this->pendingKey, this->pendingState);
+    this->pendingKey = SolutionKey();
+    return true;
+}
+
+bool LinearProgrammingProblem::isSolving() const {
+    return this->pendingSolution.valid();
+}
+
 
 const LinearProgrammingProblem::Solution* LinearProgrammingProblem::getSolution() {
     return &this->solution;
 }
+
+// Both only ever go up, so the sum changes whenever either one does
+unsigned long LinearProgrammingProblem::getRevision() const {
+    return this->constraintsRevision + this->solutionRevision;
+}
+
+unsigned long LinearProgrammingProblem::getConstraintsRevision() const {
+    return this->constraintsRevision;
+}
+
+void LinearProgrammingProblem::setSolutionCacheCapacity(size_t bytes) {
+    this->solutionCache->capacityBytes = bytes;
+    this->solutionCache->evict(bytes);
+}
+
+SolutionCacheStats LinearProgrammingProblem::getSolutionCacheStats() const {
+    SolutionCacheStats stats;
+    stats.hits = this->solutionCache->hits;
+    stats.misses = this->solutionCache->misses;
+    stats.entryCount = this->solutionCache->entries.size();
+    stats.bytes = this->solutionCache->bytes;
+    stats.capacityBytes = this->solutionCache->capacityBytes;
+    return stats;
+}
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "solver.h"
+#include "generators.h"
+#include "config.h"
+
+#ifdef USE_CDDLIB
+#include <cdd/setoper.h>
+#include <cdd/cdd.h>
+#endif
+
+using std::cout;
+using std::endl;
+
+typedef std::chrono::steady_clock benchClock;
+
+// Nanoseconds per iteration, since that's the scale we care about for these
+double perIteration(benchClock::time_point start, benchClock::time_point end, int iterations) {
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+void report(const char* name, double nanoseconds) {
+    cout << name << ": " << nanoseconds << " ns/iter" << endl;
+}
+
+#ifdef USE_CDDLIB
+// The sample cube, straight into cddlib's b - Ax >= 0 rows, maximizing 2x + 3y
+dd_MatrixPtr makeCubeMatrix() {
+    const double rows[6][4] = {
+        { 0,  1,  0,  0 }, { 0,  0,  1,  0 }, { 0,  0,  0,  1 },
+        { 1, -1,  0,  0 }, { 1,  0, -1,  0 }, { 1,  0,  0, -1 }
+    };
+    dd_MatrixPtr matrix = dd_CreateMatrix(6, 4);
+    for (int row = 0; row < 6; row++) {
+        for (int column = 0; column < 4; column++) dd_set_d(matrix->matrix[row][column], rows[row][column]);
+    }
+    dd_set_d(matrix->rowvec[1], 2);
+    dd_set_d(matrix->rowvec[2], 3);
+    matrix->representation = dd_Inequality;
+    matrix->objective = dd_LPmax;
+    return matrix;
+}
+
+void solveCubeMatrix() {
+    dd_ErrorType error = dd_NoError;
+    dd_MatrixPtr matrix = makeCubeMatrix();
+    dd_LPPtr lp = dd_Matrix2LP(matrix, &error);
+    dd_LPSolve(lp, dd_DualSimplex, &error);
+    dd_FreeLPData(lp);
+    dd_FreeMatrix(matrix);
+}
+#endif
+
+/**
+ * The same cddlib LP on the cube, done the way every solve() used to (global constants brought up
+ * and torn down around it) or under SolverContext, which keeps them around.
+ * The per-solve one has to run before anything touches SolverContext, since it frees them at the end.
+ */
+double bench_cddlib_lp(int iterations, bool isContextPerSolve) {
+    #ifdef USE_CDDLIB
+    if (isContextPerSolve) {
+        auto start = benchClock::now();
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            dd_set_global_constants();
+            solveCubeMatrix();
+            dd_free_global_constants();
+        }
+        return perIteration(start, benchClock::now(), iterations);
+    }
+    SolverContext& context = SolverContext::get();
+    std::lock_guard<std::mutex> cddlibLock(context.lock);
+    auto start = benchClock::now();
+    for (int iteration = 0; iteration < iterations; iteration++) solveCubeMatrix();
+    return perIteration(start, benchClock::now(), iterations);
+    #else
+    return 0;
+    #endif
+}
+
+double bench_small_solve(int iterations, SolverEngine engine) {
+    std::unique_ptr<LinearProgrammingProblem> problem = std::make_unique<LinearProgrammingProblem>();
+    makeCube(problem.get());
+    problem->engine = engine;
+    problem->setSolutionCacheCapacity(0); // Same system every time, it'd be timing cache hits otherwise
+    problem->solve(); // Warm up, and bring up the context outside of the timed loop
+
+    auto start = benchClock::now();
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        // Touch a plane, otherwise solve() figures out nothing changed and skips the work
+        problem->editLimitPlane(0, {0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+        problem->solve();
+    }
+    return perIteration(start, benchClock::now(), iterations);
+}
+
+double bench_enumeration(int iterations, int planeCount, EnumerationEngine enumeration) {
+    std::unique_ptr<LinearProgrammingProblem> problem = std::make_unique<LinearProgrammingProblem>();
+    makeSphere(problem.get(), planeCount);
+    problem->enumeration = enumeration;
+    problem->setSolutionCacheCapacity(0);
+
+    auto start = benchClock::now();
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        problem->editLimitPlane(0, problem->getLimitPlane(0).equationCoefficients);
+        problem->solve();
+    }
+    return perIteration(start, benchClock::now(), iterations);
+}
+
+struct BatchInput {
+    std::vector<glm::vec4> planes;
+    std::vector<BatchProblem> problems;
+};
+
+/**
+ * Random small problems, 8 planes each, pointing every which way at some distance from the origin.
+ * Some end up open along the objective, which is about what a sweep sees too.
+ */
+BatchInput makeBatch(int problemCount) {
+    const int planesEach = 8;
+    std::mt19937 generator(7);
+    std::normal_distribution<float> normal(0, 1);
+    std::uniform_real_distribution<float> offset(0.5, 2);
+    std::uniform_real_distribution<float> objective(-1, 1);
+
+    BatchInput input;
+    input.planes.reserve(static_cast<size_t>(problemCount) * planesEach);
+    for (int plane = 0; plane < problemCount * planesEach; plane++) {
+        input.planes.push_back({ normal(generator), normal(generator), normal(generator), offset(generator) });
+    }
+    input.problems.resize(problemCount);
+    for (int index = 0; index < problemCount; index++) {
+        BatchProblem& problem = input.problems[index];
+        problem.planes = &input.planes[static_cast<size_t>(index) * planesEach];
+        problem.planeCount = planesEach;
+        problem.objectiveFunction = { objective(generator), objective(generator), objective(generator), 0 };
+        problem.doMinimize = false;
+    }
+    return input;
+}
+
+// Problems per second, unlike the rest
+double bench_batch(const BatchInput& input, int threadCount) {
+    std::vector<BatchResult> results(input.problems.size());
+    auto start = benchClock::now();
+    LinearProgrammingProblem::solveBatch(input.problems.data(), input.problems.size(), results.data(), threadCount);
+    double seconds = std::chrono::duration<double>(benchClock::now() - start).count();
+    return input.problems.size() / seconds;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::stoi(argv[1]) : 10000;
+
+    cout << "Running benchmarks, " << iterations << " iterations each" << endl;
+    cout << "===========================\n";
+
+    double perSolveContextTime = bench_cddlib_lp(iterations, true);
+    double persistentContextTime = bench_cddlib_lp(iterations, false);
+    double solveTime = bench_small_solve(iterations, SolverEngine::ENGINE_CDDLIB);
+    double seidelSolveTime = bench_small_solve(iterations, SolverEngine::ENGINE_SEIDEL);
+
+    report("cddlib LP on the cube, per-solve context", perSolveContextTime);
+    report("cddlib LP on the cube, persistent context", persistentContextTime);
+    report("Small solve", solveTime);
+    report("Small solve, Seidel for the optimum", seidelSolveTime);
+
+    // These are way slower, so fewer rounds
+    for (int planeCount : { 100, 1000, 10000 }) {
+        int rounds = std::max(1, iterations / planeCount);
+        std::string suffix = std::to_string(planeCount) + " planes";
+        report(("Double description, " + suffix).c_str(), bench_enumeration(rounds, planeCount, EnumerationEngine::ENUMERATION_DOUBLE_DESCRIPTION));
+        report(("Dual hull, " + suffix).c_str(), bench_enumeration(rounds, planeCount, EnumerationEngine::ENUMERATION_DUAL_HULL));
+    }
+
+    // Throughput over the whole machine, doubling threads until there's no more cores to give
+    BatchInput batch = makeBatch(std::max(1000, iterations * 10));
+    bench_batch(batch, 1); // Warm up, context and all
+    int coreCount = std::max(1u, std::thread::hardware_concurrency());
+    double singleThreaded = 0;
+    for (int threadCount = 1; ; threadCount *= 2) {
+        threadCount = std::min(threadCount, coreCount);
+        double throughput = bench_batch(batch, threadCount);
+        if (threadCount == 1) singleThreaded = throughput;
+        cout << "Batch solve, " << batch.problems.size() << " problems on " << threadCount << " threads: "
+             << throughput << " problems/s (x" << throughput / singleThreaded << ")" << endl;
+        if (threadCount == coreCount) break;
+    }
+
+    cout << "===========================\n";
+    return 0;
+}
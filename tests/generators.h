@@ -0,0 +1,140 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include <glm/glm.hpp>
+
+#include "solver.h"
+
+/**
+ * Problems for the benchmarks, all of them reproducible off the generator's seed.
+ * The random ones are centered on the origin, bounded, and their objective doesn't line up with any face.
+ */
+
+// Good old cube, same as the "Sample cube" example
+inline void makeCube(LinearProgrammingProblem* problem) {
+    problem->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+    problem->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    problem->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    problem->addLimitPlane({1, 0, 0, 1});
+    problem->addLimitPlane({0, 1, 0, 1});
+    problem->addLimitPlane({0, 0, 1, 1});
+    problem->objectiveFunction = { 2, 3, 0, 0 };
+    problem->doMinimize = false;
+}
+
+// The "Pyramid thing" example, with its four-plane vertices
+inline void makePyramid(LinearProgrammingProblem* problem) {
+    problem->addLimitPlane({ 0.5,  0.5,  0.5, 1.0});
+    problem->addLimitPlane({ 0.5, -0.5,  0.5, 1.0});
+    problem->addLimitPlane({-0.5, -0.5,  0.5, 1.0});
+    problem->addLimitPlane({-0.5,  0.5,  0.5, 1.0});
+    problem->addLimitPlane({ 1.0,  1.0, -0.5, 0.5});
+    problem->addLimitPlane({ 1.0, -1.0, -0.5, 0.5});
+    problem->addLimitPlane({-1.0, -1.0, -0.5, 0.5});
+    problem->addLimitPlane({-1.0,  1.0, -0.5, 0.5});
+    problem->objectiveFunction = { 0, 0, 1, 0 };
+    problem->doMinimize = false;
+}
+
+// Planes tangent to the unit sphere, spread out along a golden spiral. Every one of them is a facet
+inline void makeSphere(LinearProgrammingProblem* problem, int planeCount) {
+    const float goldenAngle = 2.39996323f;
+    for (int plane = 0; plane < planeCount; plane++) {
+        float z = 1 - 2 * (plane + 0.5f) / planeCount;
+        float radius = std::sqrt(1 - z * z);
+        problem->addLimitPlane({radius * std::cos(goldenAngle * plane), radius * std::sin(goldenAngle * plane), z, 1});
+    }
+    problem->objectiveFunction = { 1, 1, 1, 0 };
+    problem->doMinimize = false;
+}
+
+// Normally distributed, then normalized, is uniform over the sphere
+inline glm::vec3 randomDirection(std::mt19937& generator) {
+    std::normal_distribution<float> normal(0, 1);
+    glm::vec3 direction;
+    do {
+        direction = glm::vec3(normal(generator), normal(generator), normal(generator));
+    } while (glm::dot(direction, direction) < 1e-6f);
+    return glm::normalize(direction);
+}
+
+// Random rotation as three orthonormal axes, Gram-Schmidt over two random directions
+inline glm::mat3 randomRotation(std::mt19937& generator) {
+    glm::vec3 x = randomDirection(generator);
+    glm::vec3 y;
+    do {
+        y = randomDirection(generator);
+        y = y - x * glm::dot(x, y);
+    } while (glm::dot(y, y) < 1e-4f);
+    y = glm::normalize(y);
+    return glm::mat3(x, y, glm::cross(x, y));
+}
+
+// Tangent planes again, but at random, so there's clusters and gaps like real input has
+inline void makeRandomSphere(LinearProgrammingProblem* problem, int planeCount, std::mt19937& generator) {
+    for (int plane = 0; plane < planeCount; plane++) {
+        glm::vec3 normal = randomDirection(generator);
+        problem->addLimitPlane({normal.x, normal.y, normal.z, 1});
+    }
+    problem->objectiveFunction = { 1, 2, 3, 0 };
+    problem->doMinimize = false;
+}
+
+/**
+ * Randomly turned copies of a shape around the origin, all intersected.
+ * Axes are the shape's face normals in its own frame, so 3 of them for cubes, 4 for cross-polytopes.
+ * Rounds the plane count up to whole copies.
+ */
+inline void makeRotatedCopies(LinearProgrammingProblem* problem, int planeCount, std::mt19937& generator, const glm::vec3* axes, int axisCount) {
+    for (int placed = 0; placed < planeCount; placed += axisCount * 2) {
+        glm::mat3 rotation = randomRotation(generator);
+        for (int axis = 0; axis < axisCount; axis++) {
+            glm::vec3 normal = rotation * glm::normalize(axes[axis]);
+            problem->addLimitPlane({normal.x, normal.y, normal.z, 1});
+            problem->addLimitPlane({-normal.x, -normal.y, -normal.z, 1});
+        }
+    }
+    problem->objectiveFunction = { 1, 2, 3, 0 };
+    problem->doMinimize = false;
+}
+
+inline void makeRandomCubes(LinearProgrammingProblem* problem, int planeCount, std::mt19937& generator) {
+    const glm::vec3 axes[3] = { {1, 0, 0}, {0, 1, 0}, {0, 0, 1} };
+    makeRotatedCopies(problem, planeCount, generator, axes, 3);
+}
+
+// |x| + |y| + |z| <= 1, eight faces
+inline void makeRandomCrossPolytopes(LinearProgrammingProblem* problem, int planeCount, std::mt19937& generator) {
+    const glm::vec3 axes[4] = { {1, 1, 1}, {1, 1, -1}, {1, -1, 1}, {-1, 1, 1} };
+    makeRotatedCopies(problem, planeCount, generator, axes, 4);
+}
+
+/**
+ * Regular prism, z from -1 to 1, with three more planes per side through its edges:
+ * an upright one through the corner with the next side, halfway between the two,
+ * and one leaned over onto each of its top and bottom edges. None of them are parallel
+ * to anything, so presolve keeps them all, and every corner ends up with six planes through it.
+ * The kind of input that trips up anything assuming three planes per vertex.
+ * Sides are a quarter of the plane count, give or take.
+ */
+inline void makeDegeneratePrism(LinearProgrammingProblem* problem, int planeCount) {
+    const float pi = 3.14159265f;
+    int sideCount = std::max(3, (planeCount - 2) / 4);
+    // Corners sit further out than the sides do
+    float cornerDistance = 1 / std::cos(pi / sideCount);
+    for (int side = 0; side < sideCount; side++) {
+        float angle = 2 * pi * side / sideCount;
+        float cornerAngle = angle + pi / sideCount;
+        float x = std::cos(angle), y = std::sin(angle);
+        problem->addLimitPlane({x, y, 0, 1});
+        problem->addLimitPlane({std::cos(cornerAngle), std::sin(cornerAngle), 0, cornerDistance});
+        problem->addLimitPlane({x, y, 1, 2});
+        problem->addLimitPlane({x, y, -1, 2});
+    }
+    problem->addLimitPlane({0, 0, 1, 1});
+    problem->addLimitPlane({0, 0, 1, -1}, EquationType::GREATER_EQUAL_THAN);
+    problem->objectiveFunction = { 1, 2, 3, 0 };
+    problem->doMinimize = false;
+}
@@ -0,0 +1,285 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <glm/glm.hpp>
+
+#include "solver.h"
+#include "mesh.h"
+#include "generators.h"
+#include "config.h"
+
+/**
+ * lpp_bench: the regression suite, as opposed to run-benchmarks poking at one thing at a time.
+ * Every generator at every size from 10 to --max-planes planes, through both vertex enumerations
+ * (double description only up to --dd-max-planes, it gets slow fast), timing solve() itself,
+ * its stages out of SolveStats, and the meshes Display would build from the result.
+ *
+ * One JSON object per line on stdout, first line says what build this was:
+ *   {"bench":"lpp_bench","seed":7,"timings":true,"cddlib":true}
+ *   {"generator":"sphere","planes":1000,"enumeration":"dual_hull","repeats":40,"solve_us":..,...}
+ * Everything's per repeat. Memory is the case's own high-water mark where it can be: on Linux the peak
+ * gets reset before every case (/proc/self/clear_refs), and peak_rss_kb is as high as resident memory went
+ * during it, start_rss_kb what was already there when it started. Elsewhere there's only the process'
+ * peak so far, which goes out as process_peak_rss_kb instead: after the first big case, that's all it shows.
+ * Each case seeds its own generator, so the same flags give the same problems whatever else got run.
+ */
+
+namespace Options {
+    int maxPlanes = 100000;
+    int ddMaxPlanes = 1000;
+    unsigned int seed = 7;
+    double minSeconds = 0.2; // Repeat each case until it's taken this long
+}
+
+typedef std::chrono::steady_clock benchClock;
+
+double microsecondsSince(benchClock::time_point start) {
+    return std::chrono::duration<double, std::micro>(benchClock::now() - start).count();
+}
+
+// "VmHWM:     1234 kB" and friends, 0 if there's no such line (or no /proc)
+size_t readStatusKilobytes(const char* key) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    size_t keyLength = std::strlen(key);
+    while (std::getline(status, line)) {
+        if (line.compare(0, keyLength, key) == 0 && line.size() > keyLength && line[keyLength] == ':')
+            return std::strtoull(line.c_str() + keyLength + 1, nullptr, 10);
+    }
+    return 0;
+}
+
+/**
+ * Starts the high-water mark over from what's resident right now, so the next readout is the case's own.
+ * Freed memory malloc kept around from earlier cases would count as resident, so that goes back first.
+ * Linux only (4.0 onwards), false anywhere else.
+ */
+bool resetPeakMemory() {
+    #ifdef __linux__
+    #ifdef __GLIBC__
+    malloc_trim(0);
+    #endif
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    clearRefs.close();
+    return !clearRefs.fail() && readStatusKilobytes("VmHWM") > 0;
+    #else
+    return false;
+    #endif
+}
+
+// Whole process, since it started
+size_t processPeakMemoryKilobytes() {
+    #ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.PeakWorkingSetSize / 1024;
+    #else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    #ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // Bytes over there
+    #else
+    return usage.ru_maxrss;
+    #endif
+    #endif
+}
+
+struct Generator {
+    const char* name;
+    void (*make)(LinearProgrammingProblem* problem, int planeCount, std::mt19937& generator);
+    int fixedPlaneCount; // 0 if it takes any
+};
+
+const Generator generators[] = {
+    { "sample_cube", [](LinearProgrammingProblem* problem, int, std::mt19937&) { makeCube(problem); }, 6 },
+    { "pyramid", [](LinearProgrammingProblem* problem, int, std::mt19937&) { makePyramid(problem); }, 8 },
+    { "sphere", makeRandomSphere, 0 },
+    { "cubes", makeRandomCubes, 0 },
+    { "cross_polytopes", makeRandomCrossPolytopes, 0 },
+    { "degenerate_prism", [](LinearProgrammingProblem* problem, int planeCount, std::mt19937&) { makeDegeneratePrism(problem, planeCount); }, 0 },
+};
+
+const char* enumerationName(EnumerationEngine enumeration) {
+    return enumeration == EnumerationEngine::ENUMERATION_DUAL_HULL ? "dual_hull" : "double_description";
+}
+
+void appendNumber(std::string& output, const char* key, double number) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), ",\"%s\":%.9g", key, number);
+    output += buffer;
+}
+
+// Whatever the solver says, minus quotes and backslashes, so it can go straight into JSON
+std::string plainText(const std::string& text) {
+    std::string plain;
+    for (char character : text) {
+        if (character == '"' || character == '\\' || static_cast<unsigned char>(character) < 0x20) plain += ' ';
+        else plain += character;
+    }
+    return plain;
+}
+
+void runCase(const Generator& generator, int planeCount, EnumerationEngine enumeration) {
+    const bool isPeakPerCase = resetPeakMemory();
+    const size_t startKilobytes = isPeakPerCase ? readStatusKilobytes("VmRSS") : 0;
+    std::unique_ptr<LinearProgrammingProblem> problem = std::make_unique<LinearProgrammingProblem>();
+    std::mt19937 random(Options::seed + planeCount);
+    generator.make(problem.get(), planeCount, random);
+    problem->engine = SolverEngine::ENGINE_SEIDEL;
+    problem->enumeration = enumeration;
+    // Every repeat is the same system, so with the cache on all but the first would be a lookup
+    problem->setSolutionCacheCapacity(0);
+
+    std::string output = std::string("{\"generator\":\"") + generator.name + "\"";
+    appendNumber(output, "planes", problem->getEquationCount());
+    output += std::string(",\"enumeration\":\"") + enumerationName(enumeration) + "\"";
+
+    double solveMicroseconds = 0;
+    double stageMicroseconds[SOLVE_STAGE_COUNT] = {};
+    int repeats = 0;
+    auto caseStart = benchClock::now();
+    try {
+        do {
+            // Touch a plane, otherwise solve() figures out nothing changed and skips the work
+            auto plane = problem->getLimitPlane(0);
+            problem->editLimitPlane(0, plane.equationCoefficients, plane.type);
+            auto solveStart = benchClock::now();
+            problem->solve();
+            solveMicroseconds += microsecondsSince(solveStart);
+            const SolveStats& stats = problem->getSolution()->stats;
+            for (int stage = 0; stage < SOLVE_STAGE_COUNT; stage++) stageMicroseconds[stage] += stats.stageMicroseconds[stage];
+            repeats++;
+        } while (microsecondsSince(caseStart) < Options::minSeconds * 1e6);
+    } catch (std::runtime_error &error) {
+        output += ",\"error\":\"" + plainText(error.what()) + "\"}\n";
+        std::fputs(output.c_str(), stdout);
+        return;
+    }
+
+    const auto* solution = problem->getSolution();
+    bool isBounded = solution->polyhedraRays.empty();
+    double triangleMicroseconds = 0, edgeMicroseconds = 0;
+    size_t triangleCount = 0;
+    for (int repeat = 0; repeat < repeats; repeat++) {
+        auto meshStart = benchClock::now();
+        triangleCount = getSolutionTriangles(solution->polyhedraVertices, solution->facets, isBounded).size() / 3;
+        triangleMicroseconds += microsecondsSince(meshStart);
+        meshStart = benchClock::now();
+        getSolutionEdges(solution->polyhedraVertices, solution->adjacency);
+        edgeMicroseconds += microsecondsSince(meshStart);
+    }
+
+    appendNumber(output, "repeats", repeats);
+    output += std::string(",\"status\":\"") + plainText(solution->statusString) + "\"";
+    appendNumber(output, "solve_us", solveMicroseconds / repeats);
+    const SolveStats& stats = solution->stats;
+    if (stats.hasTimings) {
+        // The dual hull does its adjacency along with the vertices, so that one's all in enumeration_us
+        double enumeration = stageMicroseconds[STAGE_DUAL_HULL] + stageMicroseconds[STAGE_DOUBLE_DESCRIPTION]
+            + stageMicroseconds[STAGE_COPY_GENERATORS] + stageMicroseconds[STAGE_CONVERT];
+        double adjacency = stageMicroseconds[STAGE_COPY_ADJACENCY] + stageMicroseconds[STAGE_ADJACENCY];
+        appendNumber(output, "enumeration_us", enumeration / repeats);
+        appendNumber(output, "adjacency_us", adjacency / repeats);
+        output += ",\"stages_us\":{";
+        bool isFirst = true;
+        for (int stage = 0; stage < SOLVE_STAGE_COUNT; stage++) {
+            if (stageMicroseconds[stage] == 0) continue;
+            char buffer[64];
+            std::snprintf(buffer, sizeof(buffer), "%s\"%s\":%.9g", isFirst ? "" : ",",
+                SolveStats::getStageName(static_cast<SolveStage>(stage)), stageMicroseconds[stage] / repeats);
+            output += buffer;
+            isFirst = false;
+        }
+        output += '}';
+    }
+    appendNumber(output, "mesh_us", triangleMicroseconds / repeats);
+    appendNumber(output, "wireframe_us", edgeMicroseconds / repeats);
+    appendNumber(output, "redundant_rows", stats.redundantRowCount);
+    appendNumber(output, "vertices", stats.vertexCount);
+    appendNumber(output, "rays", stats.rayCount);
+    appendNumber(output, "edges", stats.edgeCount);
+    appendNumber(output, "facets", stats.facetCount);
+    appendNumber(output, "triangles", triangleCount);
+    if (isPeakPerCase) {
+        appendNumber(output, "peak_rss_kb", readStatusKilobytes("VmHWM"));
+        appendNumber(output, "start_rss_kb", startKilobytes);
+    } else {
+        appendNumber(output, "process_peak_rss_kb", processPeakMemoryKilobytes());
+    }
+    output += "}\n";
+    std::fputs(output.c_str(), stdout);
+    std::fflush(stdout);
+}
+
+void printUsage(const char* executable) {
+    std::fprintf(stderr, "Usage: %s [options]\n"
+        "  --max-planes N      biggest problems to generate, 100000 by default\n"
+        "  --dd-max-planes N   biggest problems to put through double description, 1000 by default\n"
+        "  --seed N            7 by default\n"
+        "  --min-time SECONDS  repeat each case for at least this long, 0.2 by default\n", executable);
+}
+
+bool parseArguments(int argc, char** argv) {
+    for (int argument = 1; argument < argc; argument++) {
+        std::string option = argv[argument];
+        if (argument + 1 >= argc) return false;
+        const char* value = argv[++argument];
+        if (option == "--max-planes") Options::maxPlanes = std::atoi(value);
+        else if (option == "--dd-max-planes") Options::ddMaxPlanes = std::atoi(value);
+        else if (option == "--seed") Options::seed = std::strtoul(value, nullptr, 10);
+        else if (option == "--min-time") Options::minSeconds = std::atof(value);
+        else return false;
+    }
+    return Options::maxPlanes > 0 && Options::minSeconds >= 0;
+}
+
+int main(int argc, char** argv) {
+    if (!parseArguments(argc, argv)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    #ifdef USE_SOLVE_STATS
+    const bool hasTimings = true;
+    #else
+    const bool hasTimings = false;
+    #endif
+    #ifdef USE_CDDLIB
+    const bool hasCddlib = true;
+    #else
+    const bool hasCddlib = false;
+    #endif
+    std::printf("{\"bench\":\"lpp_bench\",\"seed\":%u,\"timings\":%s,\"cddlib\":%s}\n",
+        Options::seed, hasTimings ? "true" : "false", hasCddlib ? "true" : "false");
+
+    const int planeCounts[] = { 10, 100, 1000, 10000, 100000 };
+    for (const Generator& generator : generators) {
+        for (int planeCount : planeCounts) {
+            if (generator.fixedPlaneCount != 0) planeCount = generator.fixedPlaneCount;
+            if (planeCount > Options::maxPlanes) break;
+            runCase(generator, planeCount, EnumerationEngine::ENUMERATION_DUAL_HULL);
+            if (planeCount <= Options::ddMaxPlanes) runCase(generator, planeCount, EnumerationEngine::ENUMERATION_DOUBLE_DESCRIPTION);
+            if (generator.fixedPlaneCount != 0) break;
+        }
+    }
+    return 0;
+}
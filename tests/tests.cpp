@@ -1,13 +1,17 @@
+#include <cmath>
 #include <iostream>
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include <cstdarg>
+#include <sstream>
 
 #include <glm/glm.hpp>
 #include <glm/gtx/string_cast.hpp>
 
 #include "solver.h"
+#include "problem.h"
 #define LOCALMAN_IMPL
 #include "localman.h"
 
@@ -17,6 +21,9 @@ using std::cout;
 using std::cerr;
 using std::endl;
 
+// Solution tests run once per engine, with whatever this is set to
+SolverEngine testEngine = SolverEngine::ENGINE_CDDLIB;
+
 bool solver_sanity_check() {
     const glm::vec4 trialVector = {1, 1, 1, 0};
     const glm::vec4 editedVector = {1, 2, 1, 2};
@@ -31,8 +38,56 @@ bool solver_sanity_check() {
     return true;
 }
 
+bool solver_plane_handles() {
+    std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    PlaneHandle first = solver->addLimitPlane({1, 0, 0, 1});
+    PlaneHandle second = solver->addLimitPlane({0, 1, 0, 1});
+    PlaneHandle third = solver->addLimitPlane({0, 0, 1, 1});
+    if (solver->isValid(solver->addLimitPlane({0, 0, 0, 0}))) return false;
+
+    solver->removeLimitPlane(first);
+    if (solver->getEquationCount() != 2) return false;
+    if (solver->isValid(first)) return false;
+    // Survivors still point at their own planes, wherever they ended up
+    if (solver->getLimitPlane(second).equationCoefficients != glm::vec4(0, 1, 0, 1)) return false;
+    if (solver->getLimitPlane(third).equationCoefficients != glm::vec4(0, 0, 1, 1)) return false;
+    if (solver->getPlaneHandle(solver->getPlaneIndex(third)) != third) return false;
+
+    // Reused slot, but the old handle shouldn't wake up
+    PlaneHandle fourth = solver->addLimitPlane({1, 1, 0, 1});
+    if (solver->isValid(first) || !solver->isValid(fourth)) return false;
+
+    solver->editLimitPlane(solver->getPlaneIndex(second), {0, 0, 0, 0});
+    if (solver->getEquationCount() != 3) return false; // Still there until collected
+    solver->collectPointless();
+    if (solver->getEquationCount() != 2) return false;
+    if (solver->isValid(second)) return false;
+    if (solver->getLimitPlane(fourth).equationCoefficients != glm::vec4(1, 1, 0, 1)) return false;
+    return true;
+}
+
+bool solver_collect_pointless() {
+    std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    for (int plane = 1; plane <= 6; plane++) solver->addLimitPlane({1, 0, 0, static_cast<float>(plane)});
+    solver->editLimitPlane(1, {0, 0, 0, 0});
+    solver->editLimitPlane(4, {0, 0, 0, 0});
+    solver->editLimitPlane(3, {0, 0, 0, 0});
+    solver->editLimitPlane(3, {1, 0, 0, 4}); // Changed its mind
+
+    solver->collectPointless();
+    if (solver->getEquationCount() != 4) return false;
+    // Same order as before, minus the gaps
+    const float expected[] = { 1, 3, 4, 6 };
+    for (int plane = 0; plane < 4; plane++) {
+        if (solver->getLimitPlane(plane).equationCoefficients.w != expected[plane]) return false;
+        if (solver->getPlaneIndex(solver->getPlaneHandle(plane)) != plane) return false;
+    }
+    return true;
+}
+
 bool solver_invalid_solution() {
     std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    solver->engine = testEngine;
 
     const glm::vec4 constraintOne = {  1, 0, 0,  5 };  // x <= 5
     const glm::vec4 constraintTwo = { -1, 0, 0, -7 };  // -x <= -7 -> x >= 7
@@ -49,6 +104,7 @@ bool solver_invalid_solution() {
 
 bool solver_2d_solution_max() {
     std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    solver->engine = testEngine;
     solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
     solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
 
@@ -67,6 +123,7 @@ bool solver_2d_solution_max() {
 
 bool solver_2d_solution_min() {
     std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    solver->engine = testEngine;
     solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
     solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
 
@@ -87,6 +144,7 @@ bool solver_2d_solution_min() {
 
 bool solver_2d_solution_equals() {
     std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    solver->engine = testEngine;
     solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
     solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
 
@@ -106,6 +164,7 @@ bool solver_2d_solution_equals() {
 // XXX: We'll test the default cube for the lack of anything else
 bool solver_3d_solution() {
     std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    solver->engine = testEngine;
     solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
     solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
     solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
@@ -222,6 +281,581 @@ bool solver_3d_vertices() {
     return true;
 }
 
+// Same cube as above, but the last plane comes in after the first solve
+bool solver_incremental_vertices() {
+    std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    // The dual hull would take the bounded solve, and appending is double description's thing
+    solver->enumeration = EnumerationEngine::ENUMERATION_DOUBLE_DESCRIPTION;
+    solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 1});
+    solver->addLimitPlane({0, 1, 0, 1});
+
+    solver->objectiveFunction = { 3, 3, 0, 1 };
+    solver->doMinimize = false;
+    solver->solve();
+    // Open along Z, so only the bottom four are vertices
+    if (solver->getSolution()->polyhedraVertices.size() != 4 * 3) return false;
+    if (solver->getSolution()->stats.isPolyhedraCached) return false;
+
+    solver->addLimitPlane({0, 0, 1, 1});
+    solver->solve();
+    // A full rebuild gets the same vertices, so make sure it was the append that did it
+    if (!solver->getSolution()->stats.isPolyhedraCached) return false;
+
+    std::vector<glm::vec3> vertices = {
+        { 0, 0, 0 },
+        { 1, 1, 0 },
+        { 0, 1, 1 },
+        { 1, 0, 1 },
+        { 1, 0, 0 },
+        { 0, 1, 0 },
+        { 0, 0, 1 },
+        { 1, 1, 1 }
+    };
+
+    if (!solver->getSolution()->isSolved) return false;
+    auto solutionVertices = solver->getSolution()->polyhedraVertices;
+    if (solutionVertices.size() != 8 * 3) return false;
+
+    for (int vtx = 0; vtx < solutionVertices.size(); vtx += 3) {
+        auto vector = glm::vec3(solutionVertices[vtx], solutionVertices[vtx+1], solutionVertices[vtx+2]);
+        int found = -1;
+        for (int index = 0; index < vertices.size(); index++) {
+            if (vertices[index] != vector) continue;
+            found = index;
+            break;
+        }
+        if (found == -1) return false;
+        vertices.erase(vertices.begin() + found);
+    }
+
+    // An edit isn't an append, that one has to start over
+    solver->editLimitPlane(5, {0, 0, 1, 2});
+    solver->solve();
+    if (!solver->getSolution()->isSolved || solver->getSolution()->stats.isPolyhedraCached) return false;
+    return solver->getSolution()->polyhedraVertices.size() == 8 * 3;
+}
+
+// A blocking solve over a background one: the background one is stale by the time it lands
+bool solver_async_then_sync() {
+    std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 1, 1, 1});
+    solver->objectiveFunction = { 1, 1, 1, 0 };
+    solver->doMinimize = false;
+    if (!solver->solveAsync()) return false;
+
+    solver->editLimitPlane(3, {1, 1, 1, 2});
+    solver->solve();
+    if (solver->getSolution()->optimalValue != 2) return false;
+    while (solver->isSolving()) {
+        if (solver->pollSolution()) return false; // Would put the old optimum back
+        std::this_thread::yield();
+    }
+    return solver->getSolution()->optimalValue == 2;
+}
+
+bool solver_objective_only() {
+    std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 1});
+    solver->addLimitPlane({0, 1, 0, 1});
+
+    solver->objectiveFunction = { 2, 3, 0, 1 };
+    solver->doMinimize = false;
+    solver->solve();
+    if (!solver->getSolution()->isSolved) return false;
+    if (solver->getSolution()->optimalValue != 6) return false;
+
+    // Region's the same, only the optimum moves
+    solver->doMinimize = true;
+    solver->solve();
+    if (!solver->getSolution()->isSolved) return false;
+    if (solver->getSolution()->optimalValue != 1) return false;
+    if (solver->getSolution()->optimalVector.x != 0 || solver->getSolution()->optimalVector.y != 0) return false;
+
+    // Open along Z, so there's nothing to stop it
+    solver->objectiveFunction = { 0, 0, 1, 0 };
+    solver->doMinimize = false;
+    solver->solve();
+    if (solver->getSolution()->isSolved) return false;
+    if (solver->getSolution()->statusString != "dd_DualInconsistent") return false;
+
+    solver->doMinimize = true;
+    solver->solve();
+    if (!solver->getSolution()->isSolved) return false;
+    if (solver->getSolution()->optimalValue != 0) return false;
+
+    // Other engine, same everything else: still has to actually run
+    size_t misses = solver->getSolutionCacheStats().misses;
+    solver->engine = SolverEngine::ENGINE_SEIDEL;
+    solver->solve();
+    if (solver->getSolutionCacheStats().misses != misses + 1) return false;
+    if (!solver->getSolution()->isSolved || solver->getSolution()->optimalValue != 0) return false;
+
+    // x >= 2 against x <= 1: nothing left at all
+    solver->addLimitPlane({1, 0, 0, 2}, EquationType::GREATER_EQUAL_THAN);
+    solver->solve();
+    if (solver->getSolution()->isSolved || !solver->getSolution()->didMinimize) return false;
+
+    // Flipping the direction keeps it infeasible, without a solve, but the solution has to say which way it went
+    unsigned long revision = solver->getRevision();
+    misses = solver->getSolutionCacheStats().misses;
+    solver->doMinimize = false;
+    solver->solve();
+    if (solver->getSolutionCacheStats().misses != misses) return false;
+    if (solver->getSolution()->isSolved || solver->getSolution()->didMinimize) return false;
+    return solver->getRevision() != revision;
+}
+
+// No vertices to pick the new optimum from, so objective changes have to go through a real solve
+bool solver_no_enumeration() {
+    std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    solver->engine = SolverEngine::ENGINE_SEIDEL;
+    solver->enumeration = EnumerationEngine::ENUMERATION_NONE;
+    solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 1});
+    solver->addLimitPlane({0, 1, 0, 2});
+    solver->addLimitPlane({0, 0, 1, 3});
+
+    solver->objectiveFunction = { 1, 1, 1, 0 };
+    solver->doMinimize = false;
+    solver->solve();
+    if (!solver->getSolution()->isSolved) return false;
+    if (solver->getSolution()->optimalValue != 6) return false;
+    if (!solver->getSolution()->polyhedraVertices.empty()) return false;
+
+    solver->objectiveFunction = { 1, 0, 0, 0 };
+    solver->solve();
+    if (!solver->getSolution()->isSolved) return false;
+    if (solver->getSolution()->optimalValue != 1) return false;
+    return true;
+}
+
+// Has to agree with plain solve() on every problem, whichever thread got it
+bool solver_batch() {
+    // Unit cube, then a few problems cutting it up differently
+    const glm::vec4 cube[6] = { {-1, 0, 0, 0}, {0, -1, 0, 0}, {0, 0, -1, 0}, {1, 0, 0, 1}, {0, 1, 0, 1}, {0, 0, 1, 1} };
+    const glm::vec4 infeasible[2] = { {1, 0, 0, 2}, {1, 0, 0, 1} }; // x >= 2, x <= 1
+    const EquationType infeasibleTypes[2] = { EquationType::GREATER_EQUAL_THAN, EquationType::LESS_EQUAL_THAN };
+    const glm::vec4 halfspace[1] = { {1, 0, 0, 0} };
+    std::vector<BatchProblem> problems(100);
+    for (size_t index = 0; index < problems.size(); index++) {
+        BatchProblem& problem = problems[index];
+        problem.planes = cube;
+        problem.planeCount = 6;
+        problem.objectiveFunction = { float(index % 3), float(index % 5), 1, float(index) };
+        problem.doMinimize = index % 2 == 0;
+    }
+    problems[7].planes = infeasible;
+    problems[7].types = infeasibleTypes;
+    problems[7].planeCount = 2;
+    problems[42].planes = halfspace;
+    problems[42].planeCount = 1;
+    problems[42].doMinimize = false;
+
+    std::vector<BatchResult> results(problems.size());
+    LinearProgrammingProblem::solveBatch(problems.data(), problems.size(), results.data(), 3);
+
+    for (size_t index = 0; index < problems.size(); index++) {
+        LinearProgrammingProblem solver;
+        solver.engine = SolverEngine::ENGINE_SEIDEL;
+        for (uint32_t plane = 0; plane < problems[index].planeCount; plane++) {
+            EquationType type = problems[index].types ? problems[index].types[plane] : EquationType::LESS_EQUAL_THAN;
+            solver.addLimitPlane(problems[index].planes[plane], type);
+        }
+        solver.objectiveFunction = problems[index].objectiveFunction;
+        solver.doMinimize = problems[index].doMinimize;
+        solver.solve();
+
+        bool isOptimal = results[index].status == BatchStatus::BATCH_OPTIMAL;
+        if (isOptimal != solver.getSolution()->isSolved) return false;
+        if (isOptimal && results[index].optimalValue != solver.getSolution()->optimalValue) return false;
+    }
+    if (results[7].status != BatchStatus::BATCH_INFEASIBLE) return false;
+    if (results[42].status != BatchStatus::BATCH_UNBOUNDED) return false;
+    if (results[1].optimalVector != glm::vec3(1, 1, 1)) return false; // max x + y + z + 1
+    return true;
+}
+
+// Anything a redraw would care about has to move the revision, and nothing else should
+bool solver_revision() {
+    std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    unsigned long revision = solver->getRevision();
+    solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 1, 1, 1});
+    if (solver->getRevision() == revision) return false;
+
+    revision = solver->getRevision();
+    solver->getLimitPlane(0);
+    solver->getSolution();
+    if (solver->getRevision() != revision) return false;
+
+    solver->objectiveFunction = { 1, 1, 1, 0 };
+    solver->doMinimize = false;
+    solver->solve();
+    if (solver->getRevision() == revision) return false;
+
+    // Nothing changed, nothing to redraw
+    revision = solver->getRevision();
+    solver->solve();
+    if (solver->getRevision() != revision) return false;
+
+    solver->doMinimize = true;
+    solver->solve();
+    if (solver->getRevision() == revision) return false;
+
+    revision = solver->getRevision();
+    solver->editLimitPlane(3, {1, 1, 1, 2});
+    if (solver->getRevision() == revision) return false;
+
+    return true;
+}
+
+// The "Pyramid thing" example, both ways. Has a couple of vertices with four planes through them
+bool solver_dual_hull_vertices() {
+    std::vector<std::vector<float>> vertexSets;
+    std::vector<size_t> edgeCounts;
+    for (EnumerationEngine enumeration : { EnumerationEngine::ENUMERATION_DOUBLE_DESCRIPTION, EnumerationEngine::ENUMERATION_DUAL_HULL }) {
+        std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+        solver->enumeration = enumeration;
+        solver->addLimitPlane({ 0.5,  0.5,  0.5, 1.0});
+        solver->addLimitPlane({ 0.5, -0.5,  0.5, 1.0});
+        solver->addLimitPlane({-0.5, -0.5,  0.5, 1.0});
+        solver->addLimitPlane({-0.5,  0.5,  0.5, 1.0});
+        solver->addLimitPlane({ 1.0,  1.0, -0.5, 0.5});
+        solver->addLimitPlane({ 1.0, -1.0, -0.5, 0.5});
+        solver->addLimitPlane({-1.0, -1.0, -0.5, 0.5});
+        solver->addLimitPlane({-1.0,  1.0, -0.5, 0.5});
+        solver->objectiveFunction = { 0, 0, 1, 0 };
+        solver->doMinimize = false;
+        solver->solve();
+
+        vertexSets.push_back(solver->getSolution()->polyhedraVertices);
+        edgeCounts.push_back(solver->getSolution()->adjacency.getEdgeCount());
+    }
+
+    if (vertexSets[0].empty() || vertexSets[0].size() != vertexSets[1].size()) return false;
+    if (edgeCounts[0] != edgeCounts[1]) return false;
+    for (int vtx = 0; vtx < vertexSets[1].size(); vtx += 3) {
+        auto vector = glm::vec3(vertexSets[1][vtx], vertexSets[1][vtx+1], vertexSets[1][vtx+2]);
+        bool found = false;
+        for (int other = 0; other < vertexSets[0].size(); other += 3) {
+            auto expected = glm::vec3(vertexSets[0][other], vertexSets[0][other+1], vertexSets[0][other+2]);
+            if (glm::length(expected - vector) < 1e-5) found = true;
+        }
+        if (!found) return false;
+    }
+    return true;
+}
+
+// Cube from both enumerations: three neighbours a corner, twelve edges, and each one from both ends
+bool solver_adjacency() {
+    for (EnumerationEngine enumeration : { EnumerationEngine::ENUMERATION_DOUBLE_DESCRIPTION, EnumerationEngine::ENUMERATION_DUAL_HULL }) {
+        std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+        solver->enumeration = enumeration;
+        solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+        solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+        solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+        solver->addLimitPlane({1, 0, 0, 1});
+        solver->addLimitPlane({0, 1, 0, 1});
+        solver->addLimitPlane({0, 0, 1, 1});
+        solver->solve();
+
+        const auto& vertices = solver->getSolution()->polyhedraVertices;
+        const Adjacency& adjacency = solver->getSolution()->adjacency;
+        if (vertices.size() != 8 * 3 || adjacency.getVertexCount() != 8) return false;
+        if (adjacency.getEdgeCount() != 12) return false;
+        for (uint32_t vertex = 0; vertex < 8; vertex++) {
+            if (adjacency.offsets[vertex + 1] - adjacency.offsets[vertex] != 3) return false;
+            glm::vec3 position(vertices[3 * vertex], vertices[3 * vertex + 1], vertices[3 * vertex + 2]);
+            for (uint32_t neighbour = adjacency.offsets[vertex]; neighbour < adjacency.offsets[vertex + 1]; neighbour++) {
+                uint32_t other = adjacency.neighbours[neighbour];
+                // Cube edges only ever change one coordinate
+                glm::vec3 difference = glm::abs(position - glm::vec3(vertices[3 * other], vertices[3 * other + 1], vertices[3 * other + 2]));
+                if (difference.x + difference.y + difference.z != 1) return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool solver_facets() {
+    for (EnumerationEngine enumeration : { EnumerationEngine::ENUMERATION_DOUBLE_DESCRIPTION, EnumerationEngine::ENUMERATION_DUAL_HULL }) {
+        std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+        solver->enumeration = enumeration;
+        solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+        solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+        solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+        solver->addLimitPlane({1, 0, 0, 1});
+        solver->addLimitPlane({0, 1, 0, 1});
+        solver->addLimitPlane({0, 0, 1, 1});
+        solver->addLimitPlane({0, 0, 2, 2}); // Same as the one above, shouldn't make a second face
+        solver->solve();
+
+        const auto& vertices = solver->getSolution()->polyhedraVertices;
+        const FacetIncidence& facets = solver->getSolution()->facets;
+        if (facets.getFacetCount() != 6 || facets.vertices.size() != 6 * 4) return false;
+        auto vertexAt = [&vertices](uint32_t vertex) { return glm::vec3(vertices[3 * vertex], vertices[3 * vertex + 1], vertices[3 * vertex + 2]); };
+        for (size_t facet = 0; facet < 6; facet++) {
+            if (facets.offsets[facet + 1] - facets.offsets[facet] != 4) return false;
+            auto plane = solver->getLimitPlane(facets.planes[facet]);
+            glm::vec3 outward = glm::vec3(plane.equationCoefficients);
+            if (plane.type == EquationType::GREATER_EQUAL_THAN) outward = -outward;
+            // Every corner turns counter-clockwise when looking at it from outside
+            for (uint32_t corner = 0; corner < 4; corner++) {
+                glm::vec3 previous = vertexAt(facets.vertices[facets.offsets[facet] + corner]);
+                glm::vec3 current = vertexAt(facets.vertices[facets.offsets[facet] + (corner + 1) % 4]);
+                glm::vec3 next = vertexAt(facets.vertices[facets.offsets[facet] + (corner + 2) % 4]);
+                if (glm::dot(glm::cross(current - previous, next - current), outward) <= 0) return false;
+                if (glm::dot(glm::vec3(plane.equationCoefficients), current) != plane.equationCoefficients.w) return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Timings depend on the build, the counts don't
+bool solver_stats() {
+    std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 1});
+    solver->addLimitPlane({0, 1, 0, 1});
+    solver->addLimitPlane({0, 0, 1, 1});
+    solver->objectiveFunction = { 1, 1, 1, 0 };
+    solver->solve();
+
+    const SolveStats& stats = solver->getSolution()->stats;
+    if (stats.rowCount != 6 || stats.vertexCount != 8 || stats.rayCount != 0) return false;
+    if (stats.edgeCount != 12 || stats.facetCount != 6) return false;
+    if (stats.hasTimings && stats.getTotalMicroseconds() <= 0) return false;
+
+    // Objective-only: same counts, and if anything got timed, it's only the shortcut
+    solver->objectiveFunction = { 1, 0, 0, 0 };
+    solver->solve();
+    const SolveStats& shortcut = solver->getSolution()->stats;
+    if (shortcut.vertexCount != 8 || shortcut.facetCount != 6) return false;
+    if (shortcut.getTotalMicroseconds() != shortcut.stageMicroseconds[STAGE_OBJECTIVE_ONLY]) return false;
+    return true;
+}
+
+bool solver_solution_cache() {
+    std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    solver->engine = SolverEngine::ENGINE_SEIDEL;
+    solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 1});
+    solver->addLimitPlane({0, 1, 0, 1});
+    solver->addLimitPlane({0, 0, 1, 1});
+    solver->objectiveFunction = { 1, 2, 3, 0 };
+    solver->doMinimize = false;
+    solver->solve();
+    if (!solver->getSolution()->isSolved || solver->getSolution()->optimalValue != 6) return false;
+    uint64_t regionId = solver->getSolution()->regionId;
+
+    // Tweak, then revert: the second time around it's a hit
+    solver->editLimitPlane(3, {1, 0, 0, 2}, EquationType::LESS_EQUAL_THAN);
+    solver->solve();
+    if (solver->getSolution()->optimalValue != 7 || solver->getSolution()->regionId == regionId) return false;
+    solver->editLimitPlane(3, {1, 0, 0, 1}, EquationType::LESS_EQUAL_THAN);
+    solver->solve();
+    SolutionCacheStats cache = solver->getSolutionCacheStats();
+    if (cache.hits != 1 || cache.misses != 2 || cache.entryCount != 2) return false;
+    if (!solver->getSolution()->stats.isSolutionCached || solver->getSolution()->regionId != regionId) return false;
+    if (solver->getSolution()->optimalValue != 6) return false;
+
+    // Same cube typed in backwards, scaled and with the >= ones flipped over
+    solver->reset();
+    solver->addLimitPlane({0, 0, 2, 2});
+    solver->addLimitPlane({0, 3, 0, 3});
+    solver->addLimitPlane({1, 0, 0, 1});
+    solver->addLimitPlane({-4, 0, 0, 0});
+    solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 0, -1, 0});
+    solver->objectiveFunction = { 1, 2, 3, 0 };
+    solver->solve();
+    const auto* solution = solver->getSolution();
+    if (solver->getSolutionCacheStats().hits != 2 || solution->regionId != regionId) return false;
+    if (!solution->isSolved || solution->optimalValue != 6) return false;
+    // Facets have to point at this problem's planes, not the ones they were first solved with
+    const auto& facets = solution->facets;
+    for (size_t facet = 0; facet < facets.getFacetCount(); facet++) {
+        glm::vec4 plane = solver->getLimitPlane(facets.planes[facet]).equationCoefficients;
+        for (uint32_t index = facets.offsets[facet]; index < facets.offsets[facet + 1]; index++) {
+            const float* vertex = &solution->polyhedraVertices[facets.vertices[index] * 3];
+            if (std::abs(glm::dot(glm::vec3(plane), glm::vec3(vertex[0], vertex[1], vertex[2])) - plane.w) > 1e-5) return false;
+        }
+    }
+
+    // Objective's part of the key as is
+    solver->objectiveFunction = { 2, 4, 6, 0 };
+    solver->editLimitPlane(0, {0, 0, 2, 2}, EquationType::LESS_EQUAL_THAN);
+    solver->solve();
+    if (solver->getSolutionCacheStats().misses != 3 || solver->getSolution()->optimalValue != 12) return false;
+
+    solver->setSolutionCacheCapacity(0);
+    cache = solver->getSolutionCacheStats();
+    if (cache.entryCount != 0 || cache.bytes != 0) return false;
+    solver->editLimitPlane(0, {0, 0, 2, 2}, EquationType::LESS_EQUAL_THAN);
+    solver->solve();
+    return solver->getSolutionCacheStats().misses == 3 && !solver->getSolution()->stats.isSolutionCached;
+}
+
+bool solver_presolve() {
+    std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    solver->engine = SolverEngine::ENGINE_SEIDEL;
+    solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 1});
+    solver->addLimitPlane({0, 1, 0, 1});
+    solver->addLimitPlane({0, 0, 1, 1});
+    solver->addLimitPlane({2, 0, 0, 2});  // Same as x <= 1
+    solver->addLimitPlane({1, 0, 0, 3});  // Looser than it
+    solver->addLimitPlane({-1, 0, 0, -5}, EquationType::GREATER_EQUAL_THAN); // x <= 5, backwards
+    solver->addLimitPlane({0, 0, -3, 0}); // z >= 0 again
+    solver->objectiveFunction = { 1, 2, 3, 0 };
+    solver->doMinimize = false;
+    solver->solve();
+
+    const auto* solution = solver->getSolution();
+    if (!solution->isSolved || solution->optimalValue != 6) return false;
+    if (solution->redundantPlanes != std::vector<uint32_t>({ 6, 7, 8, 9 })) return false;
+    if (solution->stats.rowCount != 6 || solution->stats.redundantRowCount != 4) return false;
+    for (uint32_t plane : solution->facets.planes) {
+        if (plane >= 6) return false;
+    }
+
+    // Tighter one shows up later, so now it's the old x <= 1 that goes
+    solver->addLimitPlane({4, 0, 0, 2});
+    solver->solve();
+    solution = solver->getSolution();
+    if (!solution->isSolved || solution->optimalValue != 5.5) return false;
+    if (solution->redundantPlanes != std::vector<uint32_t>({ 3, 6, 7, 8, 9 })) return false;
+    if (!solution->polyhedraVertices.empty()) {
+        float maxX = 0;
+        for (size_t vertex = 0; vertex < solution->polyhedraVertices.size(); vertex += 3) maxX = std::max(maxX, solution->polyhedraVertices[vertex]);
+        if (maxX != 0.5) return false;
+    }
+
+    // Equalities pin the whole family down, the same one twice is still once
+    solver->reset();
+    solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 1});
+    solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 0, 1, 1});
+    solver->addLimitPlane({0, 1, 0, 1}, EquationType::EQUAL_TO);
+    solver->addLimitPlane({0, 1, 0, 1});
+    solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, -2, 0, -2}, EquationType::EQUAL_TO);
+    solver->objectiveFunction = { 1, 1, 1, 0 };
+    solver->solve();
+    solution = solver->getSolution();
+    if (!solution->isSolved || solution->optimalValue != 3) return false;
+    if (solution->redundantPlanes != std::vector<uint32_t>({ 5, 6, 7 })) return false;
+
+    // Same system with the loose plane moved up front comes out of the solution cache,
+    // and the redundant one has to be numbered the way it is now
+    solver->reset();
+    solver->addLimitPlane({1, 0, 0, 3});
+    solver->addLimitPlane({1, 0, 0, 1});
+    solver->addLimitPlane({0, 1, 0, 1});
+    solver->addLimitPlane({0, 0, 1, 1});
+    solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->objectiveFunction = { 1, 1, 1, 0 };
+    solver->solve();
+    solver->reset();
+    solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 0, 1, 1});
+    solver->addLimitPlane({0, 1, 0, 1});
+    solver->addLimitPlane({1, 0, 0, 1});
+    solver->addLimitPlane({1, 0, 0, 3});
+    solver->objectiveFunction = { 1, 1, 1, 0 };
+    solver->solve();
+    solution = solver->getSolution();
+    if (!solution->stats.isSolutionCached || solution->optimalValue != 3) return false;
+    return solution->redundantPlanes == std::vector<uint32_t>({ 6 });
+}
+
+bool solver_classify_constraints() {
+    std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
+    solver->engine = SolverEngine::ENGINE_SEIDEL;
+    solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 1});
+    solver->addLimitPlane({0, 1, 0, 1});
+    solver->addLimitPlane({0, 0, 1, 1});
+    solver->addLimitPlane({1, 2, 1, 10}); // Nowhere near, and not parallel to anything for presolve to catch
+    solver->addLimitPlane({1, 1, 1, 3});  // Only touches the (1, 1, 1) corner
+    std::vector<ConstraintClass> classes = solver->classifyConstraints();
+    const std::vector<ConstraintClass> expected = {
+        CONSTRAINT_BINDING, CONSTRAINT_BINDING, CONSTRAINT_BINDING,
+        CONSTRAINT_BINDING, CONSTRAINT_BINDING, CONSTRAINT_BINDING,
+        CONSTRAINT_REDUNDANT, CONSTRAINT_REDUNDANT
+    };
+    if (classes != expected) return false;
+    // Same answer however many threads it's spread over
+    if (solver->classifyConstraints(1) != expected || solver->classifyConstraints(3) != expected) return false;
+    if (solver->classifyConstraintsAsync().get() != expected) return false;
+
+    // Only the one that doesn't touch gets dropped, and the optimum stays put
+    solver->objectiveFunction = { 1, 1, 1, 0 };
+    solver->doMinimize = false;
+    solver->dropRedundantRows = true;
+    unsigned long constraintsRevision = solver->getConstraintsRevision();
+    solver->solve();
+    // A new solution is no reason to classify again
+    if (solver->getConstraintsRevision() != constraintsRevision) return false;
+    const auto* solution = solver->getSolution();
+    if (!solution->isSolved || solution->optimalValue != 3) return false;
+    if (solution->redundantPlanes != std::vector<uint32_t>({ 6 })) return false;
+    if (solution->stats.redundantRowCount != 1) return false;
+
+    // Nothing else changed, but it still has to go back to keeping everything
+    solver->dropRedundantRows = false;
+    solver->solve();
+    solution = solver->getSolution();
+    if (!solution->isSolved || solution->optimalValue != 3) return false;
+    if (!solution->redundantPlanes.empty() || solution->stats.redundantRowCount != 0) return false;
+
+    // With the same plane twice, either one holds it up without the other
+    solver->addLimitPlane({1, 0, 0, 1});
+    classes = solver->classifyConstraints();
+    if (classes[3] != CONSTRAINT_REDUNDANT || classes[8] != CONSTRAINT_REDUNDANT || classes[0] != CONSTRAINT_BINDING) return false;
+
+    // Squashed flat onto x = 0 by two inequalities
+    solver->reset();
+    solver->addLimitPlane({1, 0, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({1, 0, 0, 0});
+    solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 1, 0, 1});
+    solver->addLimitPlane({0, 0, 1, 0}, EquationType::GREATER_EQUAL_THAN);
+    solver->addLimitPlane({0, 0, 1, 1});
+    classes = solver->classifyConstraints();
+    return classes == std::vector<ConstraintClass>({
+        CONSTRAINT_IMPLICIT_EQUALITY, CONSTRAINT_IMPLICIT_EQUALITY,
+        CONSTRAINT_BINDING, CONSTRAINT_BINDING, CONSTRAINT_BINDING, CONSTRAINT_BINDING
+    });
+}
+
 bool solver_vertices_invalid() {
     std::unique_ptr<LinearProgrammingProblem> solver = std::make_unique<LinearProgrammingProblem>();
     solver->addLimitPlane({0, 1, 0, 0}, EquationType::GREATER_EQUAL_THAN);
@@ -240,6 +874,67 @@ bool solver_vertices_invalid() {
     return solver->getSolution()->polyhedraVertices.size() == 0;
 }
 
+bool problem_read_write() {
+    std::istringstream input(
+        "# The sample cube\n"
+        "maximize 1 1 1\n"
+        "1 0 0 <= 1  # trailing comments are fine\n"
+        "0 1 0 <= 1\n"
+        "0 0 1 = 1\n"
+        "\n"
+        "1 1 1 >= 0\n"
+        "---\n"
+        "min 0 0 1 2.5\n"
+        "0 0 1 >= -1\n"
+    );
+    LinearProgrammingProblem problem;
+    if (!readProblem(input, problem)) return false;
+    if (problem.doMinimize || problem.objectiveFunction != glm::vec4(1, 1, 1, 0)) return false;
+    if (problem.getEquationCount() != 4) return false;
+    if (problem.getLimitPlane(2).type != EquationType::EQUAL_TO) return false;
+    if (problem.getLimitPlane(3).type != EquationType::GREATER_EQUAL_THAN) return false;
+
+    // Whatever comes out has to read back the same
+    std::stringstream written;
+    writeProblem(written, problem);
+    LinearProgrammingProblem reread;
+    if (!readProblem(written, reread)) return false;
+    if (reread.doMinimize != problem.doMinimize || reread.objectiveFunction != problem.objectiveFunction) return false;
+    if (reread.getEquationCount() != problem.getEquationCount()) return false;
+    for (int planeIndex = 0; planeIndex < problem.getEquationCount(); planeIndex++) {
+        if (reread.getLimitPlane(planeIndex).equationCoefficients != problem.getLimitPlane(planeIndex).equationCoefficients) return false;
+        if (reread.getLimitPlane(planeIndex).type != problem.getLimitPlane(planeIndex).type) return false;
+    }
+
+    if (!readProblem(input, problem)) return false;
+    if (!problem.doMinimize || problem.objectiveFunction != glm::vec4(0, 0, 1, 2.5)) return false;
+    if (problem.getEquationCount() != 1) return false;
+    return !readProblem(input, problem);
+}
+
+bool problem_read_errors() {
+    const char* const brokenInputs[] = {
+        "1 0 0 < 1\n",
+        "1 0 <= 1\n",
+        "1 0 0 <= 1 2\n",
+        "maximize 1 1\n",
+        "max 1 1 1\nmin 1 1 1\n",
+        "frobnicate 1 2 3\n",
+        "1abc 0 0 <= 1\n"
+    };
+    for (const char* brokenInput : brokenInputs) {
+        std::istringstream input(brokenInput);
+        LinearProgrammingProblem problem;
+        try {
+            readProblem(input, problem);
+            return false;
+        } catch (std::runtime_error &error) {
+            if (std::string(error.what()).find("Line ") != 0) return false;
+        }
+    }
+    return true;
+}
+
 bool localman_parse_locale_plain() {
     #ifdef _WIN32
     const char* test_string = "English_United States";
@@ -301,15 +996,37 @@ int main() {
 
     try {
     test(solver_sanity_check, "Solver: Sanity check");
-    test(solver_invalid_solution, "Solver: With invalid input");
-    test(solver_2d_solution_min, "Solver: 2D solution -> min");
-    test(solver_2d_solution_max, "Solver: 2D solution -> max");
-    test(solver_2d_solution_equals, "Solver: 2D solution with = and >=");
-    test(solver_3d_solution, "Solver: 3D solution");
+    test(solver_plane_handles, "Solver: Plane handles");
+    test(solver_collect_pointless, "Solver: Collecting zeroed planes");
+    for (SolverEngine engine : { SolverEngine::ENGINE_CDDLIB, SolverEngine::ENGINE_SEIDEL }) {
+        testEngine = engine;
+        cout << "Using " << (engine == SolverEngine::ENGINE_SEIDEL ? "Seidel" : "cddlib") << " engine" << endl;
+        test(solver_invalid_solution, "Solver: With invalid input");
+        test(solver_2d_solution_min, "Solver: 2D solution -> min");
+        test(solver_2d_solution_max, "Solver: 2D solution -> max");
+        test(solver_2d_solution_equals, "Solver: 2D solution with = and >=");
+        test(solver_3d_solution, "Solver: 3D solution");
+    }
     test(solver_2d_vertices, "Solver: 2D Extreme points");
     test(solver_3d_vertices, "Solver: 3D Extreme points");
+    test(solver_incremental_vertices, "Solver: Extreme points with an appended plane");
+    test(solver_async_then_sync, "Solver: Blocking solve over a background one");
+    test(solver_objective_only, "Solver: Objective-only re-solve");
+    test(solver_revision, "Solver: Revision tracking");
+    test(solver_no_enumeration, "Solver: Optimum without enumeration");
+    test(solver_batch, "Solver: Batch solve");
+    test(solver_dual_hull_vertices, "Solver: Dual hull extreme points");
+    test(solver_adjacency, "Solver: Adjacency of a cube");
+    test(solver_facets, "Solver: Faces of a cube");
+    test(solver_stats, "Solver: Solve stats");
+    test(solver_solution_cache, "Solver: Solution cache");
+    test(solver_presolve, "Solver: Presolve");
+    test(solver_classify_constraints, "Solver: Constraint classes");
     test(solver_vertices_invalid, "Solver: Extreme points with invalid system");
 
+    test(problem_read_write, "Problem: Read and write back");
+    test(problem_read_errors, "Problem: Broken input");
+
     test(localman_parse_locale_plain, "LocalMan: Parse plain locale");
     test(localman_parse_locale_short, "LocalMan: Parse short locale");
     test(localman_parse_locale_country_only, "LocalMan: Parse country only");